@@ -1,27 +1,47 @@
 #include "aint.hpp"
+#include "mpn.hpp"
 #include <algorithm>
-#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <exception>
 
 void aint::breakout_dblock(const dblock_t &du, block_t &u0, block_t &u1) {
-  u0 = static_cast<uint32_t>(du);
-  u1 = static_cast<uint32_t>(du >> BLOCK_WIDTH);
+  u0 = static_cast<block_t>(du);
+  u1 = static_cast<block_t>(du >> BLOCK_WIDTH);
 }
 
+/**
+ * Default resource of the aints constructed by each thread.
+ */
+static thread_local std::pmr::memory_resource *thread_default_resource =
+    nullptr;
+
 aint::aint() {
   this->capacity_ = 0;
   this->size_ = 0;
-  this->blocks_ = nullptr;
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = aint::default_resource();
+}
+
+aint::aint(std::pmr::memory_resource *resource) {
+  this->capacity_ = 0;
+  this->size_ = 0;
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = resource;
 }
 
 aint::aint(block_t u) {
   this->capacity_ = 0;
   this->size_ = 0;
-  this->blocks_ = nullptr;
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = aint::default_resource();
   this->operator=(u);
 }
 
+#if AINT_BLOCK_WIDTH == 64
+aint::aint(unsigned int u) : aint(static_cast<block_t>(u)) {}
+#endif
+
 aint aint::from_dblock(const dblock_t du) {
   if (du == 0) {
     return aint();
@@ -40,22 +60,25 @@ aint aint::from_dblock(const dblock_t du) {
 aint::aint(char *str) {
   this->capacity_ = 0;
   this->size_ = 0;
-  this->blocks_ = nullptr;
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = aint::default_resource();
   this->operator=(str);
 }
 
 aint::aint(const aint &other) {
   this->capacity_ = 0;
   this->size_ = 0;
-  this->blocks_ = nullptr;
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = aint::default_resource();
   this->operator=(other);
 }
 
 aint::aint(aint &&other) noexcept {
   this->capacity_ = 0;
   this->size_ = 0;
-  this->blocks_ = nullptr;
-  this->operator=(std::move(other));
+  this->blocks_ = this->inline_blocks_;
+  this->resource_ = other.resource_;
+  this->take(other);
 }
 
 aint &aint::operator=(block_t u) {
@@ -69,33 +92,14 @@ aint &aint::operator=(block_t u) {
   return *this;
 }
 
+#if AINT_BLOCK_WIDTH == 64
+aint &aint::operator=(unsigned int u) {
+  return this->operator=(static_cast<block_t>(u));
+}
+#endif
+
 aint &aint::operator=(char *str) {
-  // Number of blocks that will be required to fit the string.
-  size_t str_block_count = (std::strlen(str) + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
-  if (str_block_count == 0) {
-    this->resize(0);
-    return *this;
-  }
-  this->resize(str_block_count);
-  this->size_ = this->capacity();
-  // Calculates the value of each blocks.
-  for (size_t block_index = 0; block_index < this->size(); block_index++) {
-    block_t block = 0;
-    for (int bit_index = 0; bit_index < BLOCK_WIDTH; bit_index++) {
-      char c = str[block_index * BLOCK_WIDTH + bit_index];
-      if (c == '1') {
-        block += std::pow(2, bit_index);
-      } else if (c == '\0') {
-        break;
-      } else if (c != '0') {
-        this->resize(0);
-        throw std::invalid_argument("str");
-      }
-    }
-    // Saves the new block value.
-    this->blocks_[block_index] = block;
-  }
-  this->refresh_size();
+  this->parse(str, std::strlen(str), 2);
   return *this;
 }
 
@@ -103,31 +107,98 @@ aint &aint::operator=(const aint &other) {
   if (this == &other) {
     return *this;
   }
-  this->resize(other.capacity());
-  for (size_t i = 0; i < other.size(); i++) {
-    this->blocks_[i] = other.blocks_[i];
+  this->reserve(other.size());
+  std::copy(other.blocks_, other.blocks_ + other.size(), this->blocks_);
+  // The blocks above the size of the aint are kept zero.
+  if (this->size() > other.size()) {
+    std::fill(this->blocks_ + other.size(), this->blocks_ + this->size(), 0);
   }
   this->size_ = other.size();
-  this->refresh_size();
   return *this;
 }
 
-aint &aint::operator=(aint &&other) noexcept {
+aint &aint::operator=(aint &&other) {
   if (this == &other) {
     return *this;
   }
-  free(this->blocks_);
+  // Blocks from another resource may not outlive it and are copied.
+  if (this->resource_ != other.resource_ && !other.is_inline()) {
+    return this->operator=(static_cast<const aint &>(other));
+  }
+  std::pmr::memory_resource *resource = this->resource_;
+  this->take(other);
+  this->resource_ = resource;
+  return *this;
+}
+
+void aint::take(aint &other) noexcept {
+  this->deallocate();
   this->capacity_ = other.capacity_;
   this->size_ = other.size_;
-  this->blocks_ = other.blocks_;
+  this->resource_ = other.resource_;
+  if (other.is_inline()) {
+    // Inline blocks cannot be taken over and are copied instead.
+    this->blocks_ = this->inline_blocks_;
+    std::copy(other.inline_blocks_, other.inline_blocks_ + other.capacity_,
+              this->inline_blocks_);
+  } else {
+    this->blocks_ = other.blocks_;
+  }
   other.capacity_ = 0;
   other.size_ = 0;
-  other.blocks_ = nullptr;
+  other.blocks_ = other.inline_blocks_;
   this->refresh_size();
-  return *this;
 }
 
-aint::~aint() { free(this->blocks_); }
+aint::~aint() { this->deallocate(); }
+
+block_t *aint::allocate(size_t n) {
+  // Prevents n * sizeof(block_t) from wrapping around to a smaller size.
+  if (n > SIZE_MAX / sizeof(block_t)) {
+    throw std::bad_alloc();
+  }
+  if (this->resource_ != nullptr) {
+    return static_cast<block_t *>(
+        this->resource_->allocate(n * sizeof(block_t), alignof(block_t)));
+  }
+  auto blocks = static_cast<block_t *>(malloc(n * sizeof(block_t)));
+  if (blocks == nullptr) {
+    throw std::bad_alloc();
+  }
+  return blocks;
+}
+
+void aint::deallocate() noexcept {
+  if (this->is_inline()) {
+    return;
+  }
+  if (this->resource_ != nullptr) {
+    this->resource_->deallocate(this->blocks_,
+                                this->capacity_ * sizeof(block_t),
+                                alignof(block_t));
+  } else {
+    free(this->blocks_);
+  }
+}
+
+std::pmr::memory_resource *aint::resource() const noexcept {
+  return this->resource_;
+}
+
+std::pmr::memory_resource *aint::default_resource() noexcept {
+  return thread_default_resource;
+}
+
+std::pmr::memory_resource *
+aint::set_default_resource(std::pmr::memory_resource *resource) noexcept {
+  std::pmr::memory_resource *previous = thread_default_resource;
+  thread_default_resource = resource;
+  return previous;
+}
+
+bool aint::is_inline() const noexcept {
+  return this->blocks_ == this->inline_blocks_;
+}
 
 size_t aint::capacity() const noexcept { return this->capacity_; }
 
@@ -139,23 +210,44 @@ void aint::resize(size_t n) {
   }
   // Sets the aint to zero if the new size is zero.
   if (n == 0) {
-    free(this->blocks_);
-    this->blocks_ = nullptr;
+    this->deallocate();
+    this->blocks_ = this->inline_blocks_;
     this->capacity_ = 0;
     this->size_ = 0;
     return;
   }
-  auto new_blocks =
-      static_cast<block_t *>(realloc(this->blocks_, n * sizeof(block_t)));
-  if (new_blocks == nullptr) {
-    throw std::bad_alloc();
-  }
-  this->blocks_ = new_blocks;
-  this->capacity_ = n;
   // If the new size is smaller than the previous.
-  if (this->size() > this->capacity()) {
+  if (this->size() > n) {
     this->size_ = n;
   }
+  if (n <= AINT_INLINE_CAPACITY) {
+    // Moves the blocks back into the aint.
+    if (!this->is_inline()) {
+      std::copy(this->blocks_, this->blocks_ + this->size(),
+                this->inline_blocks_);
+      this->deallocate();
+      this->blocks_ = this->inline_blocks_;
+    }
+  } else if (this->is_inline()) {
+    block_t *new_blocks = this->allocate(n);
+    std::copy(this->inline_blocks_, this->inline_blocks_ + this->size(),
+              new_blocks);
+    this->blocks_ = new_blocks;
+  } else if (this->resource_ != nullptr) {
+    // Memory resources cannot reallocate in place.
+    block_t *new_blocks = this->allocate(n);
+    std::copy(this->blocks_, this->blocks_ + this->size(), new_blocks);
+    this->deallocate();
+    this->blocks_ = new_blocks;
+  } else {
+    auto new_blocks =
+        static_cast<block_t *>(realloc(this->blocks_, n * sizeof(block_t)));
+    if (new_blocks == nullptr) {
+      throw std::bad_alloc();
+    }
+    this->blocks_ = new_blocks;
+  }
+  this->capacity_ = n;
   // Resets trailing blocks to zero.
   for (size_t i = this->size(); i < this->capacity(); i++) {
     this->blocks_[i] = 0;
@@ -186,192 +278,109 @@ void aint::swap(aint &other) noexcept {
   if (this == &other) {
     return;
   }
-  auto tmp_capacity = this->capacity_;
-  auto tmp_block_count = this->size_;
-  auto tmp_bocks = this->blocks_;
-  this->capacity_ = other.capacity_;
-  this->size_ = other.size_;
-  this->blocks_ = other.blocks_;
-  this->refresh_size();
-  other.capacity_ = tmp_capacity;
-  other.size_ = tmp_block_count;
-  other.blocks_ = tmp_bocks;
-  other.refresh_size();
+  // Inline blocks cannot be exchanged by pointer, they are taken over instead.
+  aint tmp = std::move(other);
+  other.take(*this);
+  this->take(tmp);
 }
 
-bool aint::zero() const noexcept {
-  return this->blocks_ == nullptr || this->size() == 0;
-}
+bool aint::zero() const noexcept { return this->size() == 0; }
 
-char *aint::to_string() const {
+size_t aint::bit_length() const noexcept {
   if (this->zero()) {
-    auto render = static_cast<char *>(calloc(2, sizeof(char)));
-    if (render == nullptr) {
-      throw std::bad_alloc();
-    }
-    render[0] = '0';
-    render[1] = '\0';
-    return render;
+    return 0;
   }
+  block_t top = this->blocks_[this->size() - 1];
+#if BLOCK_WIDTH == 64
+  unsigned leading_zeros = static_cast<unsigned>(__builtin_clzll(top));
+#else
+  unsigned leading_zeros = static_cast<unsigned>(__builtin_clz(top));
+#endif
+  return this->size() * BLOCK_WIDTH - leading_zeros;
+}
 
-  auto render =
-      static_cast<char *>(calloc(BLOCK_WIDTH * this->size() + 1, sizeof(char)));
-  if (render == nullptr) {
-    throw std::bad_alloc();
+size_t aint::popcount() const noexcept {
+  return mpn::popcount(this->blocks_, this->size());
+}
+
+bool aint::test_bit(size_t index) const noexcept {
+  if (index / BLOCK_WIDTH >= this->size()) {
+    return false;
   }
+  return (this->blocks_[index / BLOCK_WIDTH] >> (index % BLOCK_WIDTH)) & 1;
+}
 
-  for (size_t block_index = 0; block_index < this->size(); block_index++) {
-    block_t block = this->blocks_[block_index];
-    for (int bit_index = 0; bit_index < BLOCK_WIDTH; bit_index++) {
-      render[block_index * BLOCK_WIDTH + bit_index] = block % 2 ? '1' : '0';
-      block /= 2;
-      // Places the string end character.
-      if (block_index == this->size() - 1 && block == 0) {
-        render[block_index * BLOCK_WIDTH + bit_index + 1] = '\0';
-        break;
-      }
-    }
+size_t aint::count_trailing_zeros() const noexcept {
+  size_t i = 0;
+  for (; i < this->size() && this->blocks_[i] == 0; i++) {
   }
-  return render;
+  if (i == this->size()) {
+    return 0;
+  }
+#if BLOCK_WIDTH == 64
+  return i * BLOCK_WIDTH +
+         static_cast<size_t>(__builtin_ctzll(this->blocks_[i]));
+#else
+  return i * BLOCK_WIDTH + static_cast<size_t>(__builtin_ctz(this->blocks_[i]));
+#endif
 }
+
 /**
- * Lower/greater-like operations are done using the most-significant block first
- * on to the least. Indices are shifted by one to prevent underflow.
+ * Compares the sizes of the aints first, then their blocks from the most
+ * significant one with mpn::cmp().
+ * @return A negative value if a < b, zero if a == b, a positive value if a > b
  */
-bool aint::operator<(const aint &other) const {
-  if (this->size() < other.size()) {
-    return true;
-  }
-  if (this->size() > other.size()) {
-    return false;
+static int compare(size_t an, const block_t *a, size_t bn, const block_t *b) {
+  if (an != bn) {
+    return an < bn ? -1 : 1;
   }
+  return mpn::cmp(a, b, an);
+}
 
-  for (size_t i = this->size(); 0 < i; i--) {
-    if (*(this->blocks_ + i - 1) < *(other.blocks_ + i - 1)) {
-      return true;
-    }
-    if (*(this->blocks_ + i - 1) > *(other.blocks_ + i - 1)) {
-      return false;
-    }
-  }
-  return false;
+bool aint::operator<(const aint &other) const {
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) < 0;
 }
 
 bool aint::operator>(const aint &other) const {
-  if (this->size() > other.size()) {
-    return true;
-  }
-  if (this->size() < other.size()) {
-    return false;
-  }
-
-  for (size_t i = this->size(); 0 < i; i--) {
-    if (*(this->blocks_ + i - 1) > *(other.blocks_ + i - 1)) {
-      return true;
-    }
-    if (*(this->blocks_ + i - 1) < *(other.blocks_ + i - 1)) {
-      return false;
-    }
-  }
-  return false;
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) > 0;
 }
 
 bool aint::operator<=(const aint &other) const {
-  if (this->size() < other.size()) {
-    return true;
-  }
-  if (this->size() > other.size()) {
-    return false;
-  }
-
-  for (size_t i = this->size(); 0 < i; i--) {
-    if (*(this->blocks_ + i - 1) < *(other.blocks_ + i - 1)) {
-      return true;
-    }
-    if (*(this->blocks_ + i - 1) > *(other.blocks_ + i - 1)) {
-      return false;
-    }
-  }
-  return true;
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) <= 0;
 }
 
 bool aint::operator>=(const aint &other) const {
-  if (this->size() > other.size()) {
-    return true;
-  }
-  if (this->size() < other.size()) {
-    return false;
-  }
-
-  for (size_t i = this->size(); 0 < i; i--) {
-    if (*(this->blocks_ + i - 1) > *(other.blocks_ + i - 1)) {
-      return true;
-    }
-    if (*(this->blocks_ + i - 1) < *(other.blocks_ + i - 1)) {
-      return false;
-    }
-  }
-  return true;
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) >= 0;
 }
 
 bool aint::operator==(const aint &other) const {
-  if (this->size() != other.size()) {
-    return false;
-  }
-
-  for (size_t i = 0; i < this->size(); i++) {
-    if (*(this->blocks_ + i) != *(other.blocks_ + i)) {
-      return false;
-    }
-  }
-  return true;
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) == 0;
 }
 
 bool aint::operator!=(const aint &other) const {
-  if (this->size() != other.size()) {
-    return true;
-  }
-
-  for (size_t i = 0; i < this->size(); i++) {
-    if (*(this->blocks_ + i) != *(other.blocks_ + i)) {
-      return true;
-    }
-  }
-  return false;
+  return compare(this->size(), this->blocks_, other.size(), other.blocks_) != 0;
 }
 
 aint &aint::operator+=(const aint &other) {
-  if (this->zero()) {
-    *this = other;
-    return *this;
-  }
-  size_t new_size = this->size() + 1;
-  if (this->size() < other.size()) {
-    new_size = other.size() + 1;
-  }
-  this->reserve(new_size);
-
-  bool overflow = false;
-  for (size_t i = 0; i < new_size; i++) {
-    if (this->blocks_[i] == 0) {
-      this->blocks_[i] += overflow;
-      overflow = false;
-    } else {
-      this->blocks_[i] += overflow;
-      // The block is non-zero and we add either zero or one. An overflow can
-      // only result in the block being zero (the block was maximum).
-      overflow = this->blocks_[i] == 0;
-    }
-    // If the other aint still has a non-processed block.
-    if (other.size() >= i + 1) {
-      this->blocks_[i] += other.blocks_[i];
-      if (this->blocks_[i] < other.blocks_[i]) {
-        overflow = true;
-      }
-    }
-  }
-  this->size_ = new_size;
-  this->refresh_size();
+  size_t this_size = this->size(), other_size = other.size();
+  block_t carry;
+  if (this_size >= other_size) {
+    carry = mpn::add(this->blocks_, this->blocks_, this_size, other.blocks_,
+                     other_size);
+  } else {
+    this->reserve(other_size);
+    carry = mpn::add(this->blocks_, other.blocks_, other_size, this->blocks_,
+                     this_size);
+    this_size = other_size;
+  }
+  // The most significant block of the longest operand is non-zero, only the
+  // carry can extend the size.
+  if (carry != 0) {
+    this->reserve(this_size + 1);
+    this->blocks_[this_size] = carry;
+    this_size++;
+  }
+  this->size_ = this_size;
   return *this;
 }
 
@@ -379,149 +388,211 @@ aint &aint::operator-=(const aint &other) {
   if (other > *this) {
     throw std::invalid_argument("Cannot subtract a higher number");
   }
-  bool overflow = false;
-  block_t tmp;
-  for (size_t i = 0; i < this->size(); i++) {
-    if (this->blocks_[i] == BLOCK_MAX) {
-      this->blocks_[i] -= overflow;
-      overflow = false;
-    } else {
-      this->blocks_[i] -= overflow;
-      // The block is non-maximum and we subtract either zero or one. An
-      // overflow can only result in the block being maximum (the block was
-      // zero).
-      overflow = this->blocks_[i] == BLOCK_MAX;
-    }
-    // If the other aint still has a non-processed block.
-    if (other.size() >= i + 1) {
-      tmp = this->blocks_[i];
-      this->blocks_[i] -= other.blocks_[i];
-      if (this->blocks_[i] > tmp) {
-        overflow = true;
-      }
-    }
-  }
+  mpn::sub(this->blocks_, this->blocks_, this->size(), other.blocks_,
+           other.size());
   this->refresh_size();
   return *this;
 }
 
 aint &aint::operator*=(const aint &other) {
-  if (this->zero()) {
-    return *this;
+  *this = *this * other;
+  return *this;
+}
+
+aint &aint::operator/=(const aint &other) {
+  aint rest;
+  divmod(*this, other, *this, rest);
+  return *this;
+}
+
+aint &aint::operator%=(const aint &other) {
+  aint quotient;
+  divmod(*this, other, quotient, *this);
+  return *this;
+}
+
+aint &aint::operator+=(block_t u) {
+  size_t n = this->size();
+  block_t carry = mpn::add_1(this->blocks_, this->blocks_, n, u);
+  if (carry != 0) {
+    this->reserve(n + 1);
+    this->blocks_[n] = carry;
+    this->size_ = n + 1;
   }
-  if (other.zero()) {
-    *this = 0u;
+  return *this;
+}
+
+aint &aint::operator-=(block_t u) {
+  if (this->size() == 0 ? u != 0 : this->size() == 1 && this->blocks_[0] < u) {
+    throw std::invalid_argument("Cannot subtract a higher number");
+  }
+  mpn::sub_1(this->blocks_, this->blocks_, this->size(), u);
+  this->refresh_size();
+  return *this;
+}
+
+aint &aint::operator*=(block_t u) {
+  size_t n = this->size();
+  if (u == 0) {
+    std::fill(this->blocks_, this->blocks_ + n, 0);
+    this->size_ = 0;
     return *this;
   }
-  aint result, product;
-  size_t new_size = this->size() + other.size();
-  result.reserve(new_size);
-
-  for (size_t other_block_i = 0; other_block_i < other.size();
-       other_block_i++) {
-    for (size_t this_block_i = 0; this_block_i < this->size(); this_block_i++) {
-      product = aint::from_dblock(
-          static_cast<dblock_t>(this->blocks_[this_block_i]) *
-          static_cast<dblock_t>(other.blocks_[other_block_i]));
-      product <<= (this_block_i + other_block_i) * BLOCK_WIDTH;
-      result += product;
-    }
+  block_t carry = mpn::mul_1(this->blocks_, this->blocks_, n, u);
+  if (carry != 0) {
+    this->reserve(n + 1);
+    this->blocks_[n] = carry;
+    this->size_ = n + 1;
   }
-  result.size_ = new_size;
-  *this = result;
+  return *this;
+}
+
+aint &aint::operator/=(block_t u) {
+  if (u == 0) {
+    throw std::invalid_argument("division by zero");
+  }
+  mpn::divrem_1(this->blocks_, this->blocks_, this->size(), u);
   this->refresh_size();
   return *this;
 }
 
-aint &aint::operator/=(const aint &other) {
-  if (other.zero()) {
+aint &aint::operator%=(block_t u) {
+  if (u == 0) {
     throw std::invalid_argument("division by zero");
   }
-  if (this->zero()) {
-    return *this;
+  // The quotient is computed in place, then replaced with the remainder.
+  block_t rest = mpn::divrem_1(this->blocks_, this->blocks_, this->size(), u);
+  std::fill(this->blocks_, this->blocks_ + this->size(), 0);
+  this->size_ = 0;
+  if (rest != 0) {
+    this->blocks_[0] = rest;
+    this->size_ = 1;
   }
-  if (*this < other) {
-    *this = 0u;
-    return *this;
+  return *this;
+}
+
+void divmod(const aint &a, const aint &b, aint &q, aint &r) {
+  if (b.zero()) {
+    throw std::invalid_argument("division by zero");
   }
-  size_t bit_count = this->size() * BLOCK_WIDTH;
-  if (bit_count < this->size()) {
-    throw std::overflow_error("Dividend size too large for bit-shifting");
+  if (a < b) {
+    r = a;
+    q = 0u;
+    return;
   }
-  aint divisor = other, divisor_pow = 1u;
-  divisor <<= bit_count;     // Align divisor with dividend.
-  divisor_pow <<= bit_count; // Save the power of the divisor for the quotient.
-  aint &rest =
-      *this; // Just to keep the code clear without creating a new aint.
-  aint quotient;
-  while (rest >= other) {
-    if (rest >= divisor) {
-      rest -= divisor;
-      quotient += divisor_pow;
-    } else {
-      divisor >>= 1;
-      divisor_pow >>= 1;
+  aint quotient, rest;
+  quotient.resize(a.size() - b.size() + 1);
+  rest.resize(b.size());
+  aint scratch;
+  scratch.reserve(mpn::divrem_itch(a.size(), b.size()));
+  mpn::divrem(quotient.blocks_, rest.blocks_, a.blocks_, a.size(), b.blocks_,
+              b.size(), scratch.blocks_);
+  quotient.size_ = quotient.capacity();
+  quotient.refresh_size();
+  rest.size_ = rest.capacity();
+  rest.refresh_size();
+  q = std::move(quotient);
+  r = std::move(rest);
+}
+
+void addmul(aint &r, const aint &a, const aint &b) {
+  mul_add_shifted(r, a, b, 0);
+}
+
+/**
+ * The rows of a basecase product are subtracted from r in place. A borrow out
+ * of r means the product is higher, the rows already subtracted are then added
+ * back modulo B^n before throwing.
+ */
+void submul(aint &r, const aint &a, const aint &b) {
+  if (a.zero() || b.zero()) {
+    return;
+  }
+  const aint *x = &a, *y = &b;
+  if (x->size() < y->size()) {
+    std::swap(x, y);
+  }
+  // a * b >= B^(an + bn - 2).
+  if (x->size() + y->size() - 2 >= r.size()) {
+    throw std::invalid_argument("Cannot subtract a higher number");
+  }
+  if (&r == x || &r == y || y->size() >= mpn::thresholds.mul_karatsuba) {
+    r -= a * b;
+    return;
+  }
+  size_t n = r.size(), xn = x->size();
+  for (size_t j = 0; j < y->size(); j++) {
+    block_t *row = r.blocks_ + j;
+    block_t borrow = mpn::submul_1(row, x->blocks_, xn, y->blocks_[j]);
+    if (mpn::sub_1(row + xn, row + xn, n - j - xn, borrow) != 0) {
+      for (size_t k = 0; k <= j; k++) {
+        row = r.blocks_ + k;
+        block_t carry = mpn::addmul_1(row, x->blocks_, xn, y->blocks_[k]);
+        mpn::add_1(row + xn, row + xn, n - k - xn, carry);
+      }
+      throw std::invalid_argument("Cannot subtract a higher number");
     }
   }
-  *this = std::move(quotient);
-  this->refresh_size();
-  return *this;
+  r.refresh_size();
 }
 
-aint &aint::operator%=(const aint &other) {
-  if (other.zero()) {
-    throw std::invalid_argument("division by zero");
+void mul_add_shifted(aint &r, const aint &a, const aint &b, size_t offset) {
+  if (a.zero() || b.zero()) {
+    return;
   }
-  if (this->zero()) {
-    *this = other;
-    return *this;
+  const aint *x = &a, *y = &b;
+  if (x->size() < y->size()) {
+    std::swap(x, y);
   }
-  if (*this < other) {
-    return *this;
+  size_t block_offset = offset / BLOCK_WIDTH;
+  size_t bit_offset = offset % BLOCK_WIDTH;
+  if (bit_offset != 0 || &r == x || &r == y ||
+      y->size() >= mpn::thresholds.mul_karatsuba) {
+    aint product = a * b;
+    product <<= bit_offset;
+    size_t n = std::max(r.size(), block_offset + product.size()) + 1;
+    r.reserve(n);
+    mpn::add(r.blocks_ + block_offset, r.blocks_ + block_offset,
+             n - block_offset, product.blocks_, product.size());
+    r.size_ = n;
+    r.refresh_size();
+    return;
   }
-  size_t bit_count = this->size() * BLOCK_WIDTH;
-  if (bit_count < this->size()) {
-    throw std::overflow_error("Dividend size too large for bit-shifting");
-  }
-  aint divisor = other;
-  divisor <<= bit_count; // Align divisor with dividend.
-  while (*this >= other) {
-    if (*this >= divisor) {
-      *this -= divisor;
-    } else {
-      divisor >>= 1;
-    }
+  // The blocks above the size of r are zero, the rows are accumulated in
+  // place.
+  size_t xn = x->size();
+  size_t n = std::max(r.size(), block_offset + xn + y->size()) + 1;
+  r.reserve(n);
+  for (size_t j = 0; j < y->size(); j++) {
+    block_t *row = r.blocks_ + block_offset + j;
+    block_t carry = mpn::addmul_1(row, x->blocks_, xn, y->blocks_[j]);
+    mpn::add_1(row + xn, row + xn, n - block_offset - j - xn, carry);
   }
-  this->refresh_size();
-  return *this;
+  r.size_ = n;
+  r.refresh_size();
 }
 
+/**
+ * Whole blocks are moved with a single memmove, or shifted and moved in the
+ * same pass by mpn::lshift() which supports moving its result upwards.
+ */
 aint &aint::operator<<=(size_t offset) {
   if (this->zero() || offset == 0) {
     return *this;
   }
-  size_t new_size = this->size() + (offset + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
-  this->resize(new_size);
-
+  size_t n = this->size();
   size_t block_offset = offset / BLOCK_WIDTH;
-  block_t new_block_a, new_block_b;
-  for (size_t i = this->size(); i > 0; i--) {
-    new_block_a = this->blocks_[i - 1] << offset % BLOCK_WIDTH;
-    // If the bit shift did not overflow.
-    if (offset % BLOCK_WIDTH == 0) {
-      new_block_b = 0;
-    } else {
-      // Computes the overflowing part.
-      new_block_b =
-          this->blocks_[i - 1] >> (BLOCK_WIDTH - offset % BLOCK_WIDTH);
-    }
-    this->blocks_[i - 1] = 0;
-    this->blocks_[i - 1 + block_offset] = new_block_a;
-    // Ensures the block exists.
-    if (new_block_b != 0) {
-      this->blocks_[i - 1 + block_offset + 1] += new_block_b;
-    }
-  }
+  unsigned bit_offset = offset % BLOCK_WIDTH;
+  size_t new_size = n + block_offset + (bit_offset != 0 ? 1 : 0);
+  this->reserve(new_size);
+  if (bit_offset == 0) {
+    std::memmove(this->blocks_ + block_offset, this->blocks_,
+                 n * sizeof(block_t));
+  } else {
+    this->blocks_[n + block_offset] = mpn::lshift(
+        this->blocks_ + block_offset, this->blocks_, n, bit_offset);
+  }
+  std::fill(this->blocks_, this->blocks_ + block_offset, 0);
   this->size_ = new_size;
   this->refresh_size();
   return *this;
@@ -531,115 +602,262 @@ aint &aint::operator>>=(size_t offset) {
   if (this->zero() || offset == 0) {
     return *this;
   }
-
+  size_t n = this->size();
   size_t block_offset = offset / BLOCK_WIDTH;
-  if (block_offset >= this->size()) {
+  unsigned bit_offset = offset % BLOCK_WIDTH;
+  if (block_offset >= n) {
     *this = 0u;
     return *this;
   }
-  block_t new_block_a, new_block_b;
-  for (size_t i = 0; i < this->size(); i++) {
-    // If the bit shift did not overflow.
-    if (offset % BLOCK_WIDTH == 0) {
-      new_block_a = 0;
-    } else {
-      // Computes the overflowing part.
-      new_block_a = this->blocks_[i] << (BLOCK_WIDTH - offset % BLOCK_WIDTH);
-    }
-    new_block_b = this->blocks_[i] >> offset % BLOCK_WIDTH;
-    this->blocks_[i] = 0;
-    // Ensures the block exists.
-    if (i >= block_offset + 1) {
-      this->blocks_[i - block_offset - 1] += new_block_a;
-    }
-    // Ensures the block exists.
-    if (i >= block_offset) {
-      this->blocks_[i - block_offset] = new_block_b;
-    }
+  size_t new_size = n - block_offset;
+  if (bit_offset == 0) {
+    std::memmove(this->blocks_, this->blocks_ + block_offset,
+                 new_size * sizeof(block_t));
+  } else {
+    mpn::rshift(this->blocks_, this->blocks_ + block_offset, new_size,
+                bit_offset);
   }
+  std::fill(this->blocks_ + new_size, this->blocks_ + n, 0);
+  this->size_ = new_size;
+  this->refresh_size();
+  return *this;
+}
 
-  this->size_ -= block_offset;
+aint &aint::operator&=(const aint &other) {
+  size_t n = std::min(this->size(), other.size());
+  mpn::and_n(this->blocks_, this->blocks_, other.blocks_, n);
+  std::fill(this->blocks_ + n, this->blocks_ + this->size(), 0);
+  this->size_ = n;
   this->refresh_size();
   return *this;
 }
 
-aint aint::operator+(const aint &other) const {
-  aint res = *this;
-  res += other;
-  return res;
+aint &aint::operator|=(const aint &other) {
+  size_t n = std::min(this->size(), other.size());
+  if (other.size() > this->size()) {
+    this->reserve(other.size());
+    std::copy(other.blocks_ + n, other.blocks_ + other.size(),
+              this->blocks_ + n);
+    this->size_ = other.size();
+  }
+  mpn::ior_n(this->blocks_, this->blocks_, other.blocks_, n);
+  return *this;
 }
 
-aint aint::operator-(const aint &other) const {
-  aint res = *this;
-  res -= other;
-  return res;
+aint &aint::operator^=(const aint &other) {
+  size_t n = std::min(this->size(), other.size());
+  if (other.size() > this->size()) {
+    this->reserve(other.size());
+    std::copy(other.blocks_ + n, other.blocks_ + other.size(),
+              this->blocks_ + n);
+    this->size_ = other.size();
+  }
+  mpn::xor_n(this->blocks_, this->blocks_, other.blocks_, n);
+  this->refresh_size();
+  return *this;
 }
 
-aint aint::operator*(const aint &other) const {
-  aint res = *this;
-  res *= other;
+aint aint::operator+(const aint &other) const & {
+  const aint *a = this, *b = &other;
+  if (a->size() < b->size()) {
+    std::swap(a, b);
+  }
+  aint res;
+  if (a->zero()) {
+    return res;
+  }
+  res.resize(a->size() + 1);
+  res.blocks_[a->size()] =
+      mpn::add(res.blocks_, a->blocks_, a->size(), b->blocks_, b->size());
+  res.size_ = a->size() + (res.blocks_[a->size()] != 0);
   return res;
 }
 
-aint aint::operator/(const aint &other) const {
-  aint res = *this;
-  res /= other;
+aint aint::operator-(const aint &other) const & {
+  if (other > *this) {
+    throw std::invalid_argument("Cannot subtract a higher number");
+  }
+  aint res;
+  res.resize(this->size());
+  mpn::sub(res.blocks_, this->blocks_, this->size(), other.blocks_,
+           other.size());
+  res.size_ = this->size();
+  res.refresh_size();
   return res;
 }
 
-aint aint::operator%(const aint &other) const {
-  aint res = *this;
-  res %= other;
+aint aint::operator*(const aint &other) const & {
+  aint res;
+  if (this->zero() || other.zero()) {
+    return res;
+  }
+  const aint *a = this, *b = &other;
+  if (a->size() < b->size()) {
+    std::swap(a, b);
+  }
+  res.resize(a->size() + b->size());
+  // The scratch space comes from the default resource, as the result.
+  aint scratch;
+  scratch.reserve(mpn::mul_itch(a->size(), b->size()));
+  mpn::mul(res.blocks_, a->blocks_, a->size(), b->blocks_, b->size(),
+           scratch.blocks_);
+  res.size_ = res.capacity();
+  res.refresh_size();
   return res;
 }
 
-aint aint::operator<<(size_t offset) const {
-  aint res = *this;
-  res <<= offset;
+aint square(const aint &a) {
+  aint res;
+  if (a.zero()) {
+    return res;
+  }
+  res.resize(2 * a.size());
+  aint scratch;
+  scratch.reserve(mpn::sqr_itch(a.size()));
+  mpn::sqr(res.blocks_, a.blocks_, a.size(), scratch.blocks_);
+  res.size_ = res.capacity();
+  res.refresh_size();
   return res;
 }
 
-aint aint::operator>>(size_t offset) const {
-  aint res = *this;
-  res >>= offset;
-  return res;
+aint aint::operator/(const aint &other) const & {
+  aint quotient, rest;
+  divmod(*this, other, quotient, rest);
+  return quotient;
 }
 
-std::ostream &operator<<(std::ostream &o, const aint &ai) {
-  auto str = ai.to_string();
-  o << str;
-  free(str);
-  return o;
+aint aint::operator%(const aint &other) const & {
+  aint quotient, rest;
+  divmod(*this, other, quotient, rest);
+  return rest;
 }
 
-std::istream &operator>>(std::istream &i, aint &ai) {
-  size_t input_buffer_size = 10;
-  size_t input_size = 0;
-  auto input_buffer =
-      static_cast<char *>(calloc(input_buffer_size, sizeof(char)));
-  if (input_buffer == nullptr) {
-    throw std::bad_alloc();
+aint aint::operator<<(size_t offset) const & {
+  return aint(*this) << offset;
+}
+
+aint aint::operator>>(size_t offset) const & {
+  return aint(*this) >> offset;
+}
+
+aint aint::operator&(const aint &other) const & {
+  return aint(*this) & other;
+}
+
+aint aint::operator|(const aint &other) const & {
+  return aint(*this) | other;
+}
+
+aint aint::operator^(const aint &other) const & {
+  return aint(*this) ^ other;
+}
+
+aint aint::operator~() const & { return ~aint(*this); }
+
+aint aint::operator+(const aint &other) && {
+  *this += other;
+  return std::move(*this);
+}
+
+aint aint::operator-(const aint &other) && {
+  *this -= other;
+  return std::move(*this);
+}
+
+aint aint::operator*(const aint &other) && { return *this * other; }
+
+aint aint::operator/(const aint &other) && { return *this / other; }
+
+aint aint::operator%(const aint &other) && { return *this % other; }
+
+aint aint::operator<<(size_t offset) && {
+  *this <<= offset;
+  return std::move(*this);
+}
+
+aint aint::operator>>(size_t offset) && {
+  *this >>= offset;
+  return std::move(*this);
+}
+
+aint aint::operator&(const aint &other) && {
+  *this &= other;
+  return std::move(*this);
+}
+
+aint aint::operator|(const aint &other) && {
+  *this |= other;
+  return std::move(*this);
+}
+
+aint aint::operator^(const aint &other) && {
+  *this ^= other;
+  return std::move(*this);
+}
+
+aint aint::operator~() && {
+  if (this->zero()) {
+    return std::move(*this);
   }
-  for (char c = i.get(); !i.eof() && c != '\n'; c = i.get()) {
-    if (!isspace(c)) {
-      if (input_size + 2 > input_buffer_size) {
-        input_buffer_size *= 2;
-        input_buffer = static_cast<char *>(
-            realloc(input_buffer, input_buffer_size * sizeof(char)));
-        if (input_buffer == nullptr) {
-          throw std::bad_alloc();
-        }
-      }
-      input_buffer[input_size] = c;
-      input_size++;
-    }
+  size_t n = this->size();
+  // The bits above the most significant one of the aint stay zero.
+  unsigned top_bits = this->bit_length() % BLOCK_WIDTH;
+  mpn::com(this->blocks_, this->blocks_, n);
+  if (top_bits != 0) {
+    this->blocks_[n - 1] &= (static_cast<block_t>(1) << top_bits) - 1;
   }
-  input_buffer[input_size] = '\0';
-  try {
-    ai = input_buffer;
-  } catch (std::invalid_argument &) {
-    i.setstate(std::ios::failbit);
+  this->refresh_size();
+  return std::move(*this);
+}
+
+aint operator+(const aint &a, aint &&b) {
+  b += a;
+  return std::move(b);
+}
+
+aint operator+(aint &&a, aint &&b) { return std::move(a) + b; }
+
+/**
+ * The difference is computed in the blocks of b, mpn::sub() reading each
+ * block of b before writing the same block of the result.
+ */
+aint operator-(const aint &a, aint &&b) {
+  if (b > a) {
+    throw std::invalid_argument("Cannot subtract a higher number");
   }
-  free(input_buffer);
-  return i;
+  b.reserve(a.size());
+  mpn::sub(b.blocks_, a.blocks_, a.size(), b.blocks_, b.size());
+  b.size_ = a.size();
+  b.refresh_size();
+  return std::move(b);
+}
+
+aint operator-(aint &&a, aint &&b) { return std::move(a) - b; }
+
+aint operator&(const aint &a, aint &&b) {
+  b &= a;
+  return std::move(b);
+}
+
+aint operator&(aint &&a, aint &&b) { return std::move(a) & b; }
+
+aint operator|(const aint &a, aint &&b) {
+  b |= a;
+  return std::move(b);
+}
+
+aint operator|(aint &&a, aint &&b) { return std::move(a) | b; }
+
+aint operator^(const aint &a, aint &&b) {
+  b ^= a;
+  return std::move(b);
+}
+
+aint operator^(aint &&a, aint &&b) { return std::move(a) ^ b; }
+
+std::ostream &operator<<(std::ostream &o, const aint &ai) {
+  auto str = ai.to_string();
+  o << str;
+  free(str);
+  return o;
 }
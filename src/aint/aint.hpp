@@ -1,16 +1,47 @@
 #ifndef LAB_AINT_AINT_H_
 #define LAB_AINT_AINT_H_
+#include <cstdint>
 #include <exception>
 #include <iostream>
+#include <memory_resource>
+#include <vector>
 
+/**
+ * Width of the blocks in bits, chosen at build time (32 or 64). 64 bits blocks
+ * require a compiler providing `unsigned __int128` for the double-blocks.
+ */
+#ifndef AINT_BLOCK_WIDTH
+#define AINT_BLOCK_WIDTH 32
+#endif
+
+#if AINT_BLOCK_WIDTH == 32
 #define BLOCK_WIDTH 32
 #define BLOCK_MAX UINT32_MAX
 typedef uint32_t block_t;
 typedef uint64_t dblock_t;
+#elif AINT_BLOCK_WIDTH == 64
+#ifndef __SIZEOF_INT128__
+#error "64 bits blocks require unsigned __int128 support"
+#endif
+#define BLOCK_WIDTH 64
+#define BLOCK_MAX UINT64_MAX
+typedef uint64_t block_t;
+typedef unsigned __int128 dblock_t;
+#else
+#error "AINT_BLOCK_WIDTH must be 32 or 64"
+#endif
+
+/**
+ * Number of blocks stored inside the aint object itself, values needing more
+ * blocks being allocated on the heap.
+ */
+#ifndef AINT_INLINE_CAPACITY
+#define AINT_INLINE_CAPACITY 4
+#endif
 
 /**
  * Arbitrary-length unsigned integer class. The a-integer is represented with a
- * set of 32 bits unsigned integers called `blocks`.
+ * set of BLOCK_WIDTH bits (32 or 64) unsigned integers called `blocks`.
  *
  * @details
  * The size of the a-integer is the number of blocks used, excluding any
@@ -22,10 +53,16 @@ typedef uint64_t dblock_t;
  * @note
  * Trailing blocks are the last of the a-integer's blocks, but actually contain
  * the most significant value. The blocks can be seen as a little endian
- * representation with a 2^32 base.
+ * representation with a 2^BLOCK_WIDTH base.
  * The trailing blocks are never removed by standard operations, hence the
  * capacity of the a-integer will only grow, unless the user calls
  * aint::shrink_to_fit().
+ * Up to AINT_INLINE_CAPACITY blocks are stored in the a-integer itself, a
+ * larger capacity being allocated on the heap.
+ * The heap blocks come from the memory resource of the a-integer, or from
+ * `malloc` and `realloc` when it has none. New a-integers, including the
+ * temporaries of the operators, take the default resource of the calling
+ * thread (see aint_arena).
  */
 class aint {
 protected:
@@ -38,26 +75,130 @@ protected:
    */
   size_t size_;
   /**
-   * Array containing the blocks.
+   * Array containing the blocks, either aint::inline_blocks_ or a heap
+   * allocation.
    */
   block_t *blocks_;
   /**
-   * Splits a 64 bits unsigned integer (or double-block) into two 32 bits
-   * unsigned integers (simple blocks).
+   * Storage of the blocks while the capacity does not exceed
+   * AINT_INLINE_CAPACITY.
+   */
+  block_t inline_blocks_[AINT_INLINE_CAPACITY];
+  /**
+   * Resource providing the heap blocks, `nullptr` for the C heap.
+   */
+  std::pmr::memory_resource *resource_;
+  /**
+   * @return True if the blocks are stored in aint::inline_blocks_
+   */
+  bool is_inline() const noexcept;
+  /**
+   * Allocates `n` blocks from the resource of the aint.
+   * @throws std::bad_alloc Thrown if the allocation fails or if its size in
+   * bytes overflows
+   */
+  block_t *allocate(size_t n);
+  /**
+   * Releases the heap blocks, if any. The capacity must still be the one they
+   * were allocated with.
+   */
+  void deallocate() noexcept;
+  /**
+   * Releases the blocks of the aint and takes over the blocks and the resource
+   * of another aint, which is left zero.
+   */
+  void take(aint &other) noexcept;
+  /**
+   * Splits a double-block into two simple blocks.
    * @param du The double-block to split
-   * @param u0 The block that will contain the first 32 bits (bits 0 to 31) of
-   * the double-block
-   * @param u1 The block that will contain the last 32 bits (bits 32 to 63) of
-   * the double-block
+   * @param u0 The block that will contain the first BLOCK_WIDTH bits of the
+   * double-block
+   * @param u1 The block that will contain the last BLOCK_WIDTH bits of the
+   * double-block
    */
   static void breakout_dblock(const dblock_t &du, block_t &u0, block_t &u1);
+  /**
+   * Parses a representation of an unsigned integer and uses it to set the
+   * aint's value.
+   * @param str The representation, not necessarily null-terminated
+   * @param length The number of characters of the representation
+   * @param base The base of the representation (2, 10 or 16)
+   * @throw std::invalid_argument Thrown if a parsing error occurs, the aint
+   * being set to zero
+   * @see aint::from_string(const char *, unsigned)
+   */
+  void parse(const char *str, size_t length, unsigned base);
+  /**
+   * Parses a valid decimal representation by splitting it around a power of
+   * the largest power of ten fitting in a block, both halves being parsed
+   * recursively.
+   */
+  void parse_decimal(const char *str, size_t length);
+  /**
+   * Writes exactly d * 2^level decimal digits of an aint lower than
+   * 10^(d * 2^level), padded with leading zeros, d being the number of
+   * decimal digits fitting in a block (9 or 19).
+   * @param powers The powers 10^(d * 2^k) for k lower than `level`
+   */
+  static void render_decimal(const aint &a, size_t level,
+                             const aint *const *powers, char *out);
+  /**
+   * Euclid's algorithm with Lehmer steps, the quotients of the leading bits
+   * of u and v being applied as a single cofactor matrix.
+   * @param cofactor If not null, receives s with 0 < s <= v / g and
+   * u * s = g (mod v), requiring u and v to be non-zero
+   * @return g = gcd(u, v)
+   */
+  static aint euclid(aint u, aint v, aint *cofactor);
+  /**
+   * Multiplies the factors with a balanced product tree, the factors being
+   * left in a valid but unspecified state.
+   * @return The product, 1 if there are no factors
+   */
+  static aint product_tree(std::vector<aint> &factors);
 
 public:
   aint();
   ~aint();
+  /**
+   * Constructs a zero aint allocating its blocks from a memory resource.
+   * @param resource The resource, which must outlive the aint, or `nullptr`
+   * for the C heap
+   */
+  explicit aint(std::pmr::memory_resource *resource);
 
   aint(block_t u);
+#if AINT_BLOCK_WIDTH == 64
+  /**
+   * Keeps `unsigned int` values unambiguous with 64 bits blocks, where `0u`
+   * would otherwise also convert to `char *`.
+   */
+  aint(unsigned int u);
+#endif
   static aint from_dblock(dblock_t du);
+  /**
+   * Parses a representation of an unsigned integer in base 2, 10 or 16.
+   * @param str The representation. Base 2 is read little-endian, as with
+   * aint::operator=(char *); bases 10 and 16 are read most significant digit
+   * first, hexadecimal digits in either case.
+   * @param base The base of the representation
+   * @return The parsed aint
+   * @throw std::invalid_argument Thrown if the base is not supported or if a
+   * parsing error occurs
+   */
+  static aint from_string(const char *str, unsigned base = 2);
+  /**
+   * Multiplies a range of aints with a balanced binary product tree, so that
+   * each product has operands of similar sizes and the fast multiplications
+   * apply. The products of a level of the tree run in parallel when
+   * mpn::parallel_t::threads is above 1 and the factors of the level reach
+   * mpn::parallel_t::mul_threshold blocks.
+   * @param first The beginning of the range, which may be a move iterator
+   * @param last The end of the range
+   * @return The product, 1 for an empty range
+   */
+  template <typename Iterator>
+  static aint product(Iterator first, Iterator last);
   aint(char *str);
   aint(const aint &other);
   aint(aint &&other) noexcept;
@@ -68,6 +209,9 @@ public:
    * @return self
    */
   aint &operator=(block_t u);
+#if AINT_BLOCK_WIDTH == 64
+  aint &operator=(unsigned int u);
+#endif
   /**
    * Parses a little-endian binary representation of an unsigned integer uses it
    * to set the aint's value.
@@ -76,19 +220,74 @@ public:
    * @throw std::invalid_argument Thrown if a parsing error occurs
    */
   aint &operator=(char *str);
+  /**
+   * Copies the blocks of another aint, the capacity only growing to its size.
+   * @return self
+   * @throws std::bad_alloc Thrown if the copy cannot be allocated
+   */
   aint &operator=(const aint &other);
-  aint &operator=(aint &&other) noexcept;
+  /**
+   * Takes over the blocks of another aint sharing the same memory resource,
+   * and copies them otherwise.
+   * @return self
+   * @throws std::bad_alloc Thrown if the copy cannot be allocated
+   */
+  aint &operator=(aint &&other);
 
   /**
    * Checks if the aint equals zero.
    */
   bool zero() const noexcept;
   /**
-   * @return A little-endian binary representation of the aint
+   * @return The number of significant bits, 0 for zero
+   */
+  size_t bit_length() const noexcept;
+  /**
+   * @return The number of bits set
+   */
+  size_t popcount() const noexcept;
+  /**
+   * @param index The index of the bit, 0 being the least significant
+   * @return True if the bit is set
+   */
+  bool test_bit(size_t index) const noexcept;
+  /**
+   * @return The number of trailing zero bits, the largest k such that 2^k
+   * divides the aint, 0 for zero
+   */
+  size_t count_trailing_zeros() const noexcept;
+  /**
+   * Renders the aint in base 2, 10 or 16. Decimal conversion divides by cached
+   * powers of 10^9 (10^19 with 64 bits blocks), which is subquadratic with the
+   * Newton division.
+   * @param base The base of the representation
+   * @return A little-endian binary representation of the aint for base 2, a
+   * representation with the most significant digit first (lowercase for
+   * base 16) otherwise. The string is allocated with `malloc` and must be
+   * released with `free`.
+   * @throw std::invalid_argument Thrown if the base is not supported
    */
-  char *to_string() const;
+  char *to_string(unsigned base = 2) const;
 
+  /**
+   * Exchanges the values of two aints, along with their memory resources.
+   */
   void swap(aint &other) noexcept;
+  /**
+   * @return The memory resource of the aint, `nullptr` for the C heap.
+   */
+  std::pmr::memory_resource *resource() const noexcept;
+  /**
+   * @return The resource given to the aints constructed by the calling thread,
+   * `nullptr` (the C heap) unless changed.
+   */
+  static std::pmr::memory_resource *default_resource() noexcept;
+  /**
+   * Changes the resource given to the aints constructed by the calling thread.
+   * @return The previous default resource
+   */
+  static std::pmr::memory_resource *
+  set_default_resource(std::pmr::memory_resource *resource) noexcept;
   /**
    * @return Current number of blocks representing the aint.
    */
@@ -136,17 +335,160 @@ public:
   aint &operator*=(const aint &other);
   aint &operator/=(const aint &other);
   aint &operator%=(const aint &other);
+  /**
+   * Operations with a single block, each done in one pass over the blocks
+   * without any temporary. The capacity only grows when a carry needs a new
+   * block.
+   * @throw std::invalid_argument Thrown by `-=` if u is higher than the aint,
+   * by `/=` and `%=` if u is zero
+   */
+  aint &operator+=(block_t u);
+  aint &operator-=(block_t u);
+  aint &operator*=(block_t u);
+  aint &operator/=(block_t u);
+  aint &operator%=(block_t u);
   aint &operator<<=(size_t offset);
   aint &operator>>=(size_t offset);
+  aint &operator&=(const aint &other);
+  aint &operator|=(const aint &other);
+  aint &operator^=(const aint &other);
 
-  aint operator+(const aint &other) const;
-  aint operator-(const aint &other) const;
-  aint operator*(const aint &other) const;
-  aint operator/(const aint &other) const;
-  aint operator%(const aint &other) const;
-  aint operator<<(size_t offset) const;
-  aint operator>>(size_t offset) const;
+  aint operator+(const aint &other) const &;
+  aint operator-(const aint &other) const &;
+  aint operator*(const aint &other) const &;
+  aint operator/(const aint &other) const &;
+  aint operator%(const aint &other) const &;
+  aint operator<<(size_t offset) const &;
+  aint operator>>(size_t offset) const &;
+  aint operator&(const aint &other) const &;
+  aint operator|(const aint &other) const &;
+  aint operator^(const aint &other) const &;
+  /**
+   * @return The ones' complement of the aint within its bit_length(), so that
+   * a + ~a = 2^bit_length() - 1 (~0 is 0)
+   */
+  aint operator~() const &;
+  /**
+   * Operations on a temporary left operand, whose blocks are reused for the
+   * result by `+`, `-`, shifts and bitwise operators. A product or a division
+   * needs new blocks in any case.
+   */
+  aint operator+(const aint &other) &&;
+  aint operator-(const aint &other) &&;
+  aint operator*(const aint &other) &&;
+  aint operator/(const aint &other) &&;
+  aint operator%(const aint &other) &&;
+  aint operator<<(size_t offset) &&;
+  aint operator>>(size_t offset) &&;
+  aint operator&(const aint &other) &&;
+  aint operator|(const aint &other) &&;
+  aint operator^(const aint &other) &&;
+  aint operator~() &&;
+  /**
+   * Operations on a temporary right operand, whose blocks are reused for the
+   * result. Both operands being temporaries, the blocks of the left one are
+   * reused.
+   * @throw std::invalid_argument Thrown by `-` if b is higher than a
+   */
+  friend aint operator+(const aint &a, aint &&b);
+  friend aint operator+(aint &&a, aint &&b);
+  friend aint operator-(const aint &a, aint &&b);
+  friend aint operator-(aint &&a, aint &&b);
+  friend aint operator&(const aint &a, aint &&b);
+  friend aint operator&(aint &&a, aint &&b);
+  friend aint operator|(const aint &a, aint &&b);
+  friend aint operator|(aint &&a, aint &&b);
+  friend aint operator^(const aint &a, aint &&b);
+  friend aint operator^(aint &&a, aint &&b);
 
+  /**
+   * Computes a * a, each cross product of the blocks being computed once.
+   * @note
+   * Products of an aint with itself (`a * a`, `a *= a`) are also squared.
+   */
+  friend aint square(const aint &a);
+  /**
+   * @return The greatest common divisor of a and b, gcd(a, 0) being a
+   */
+  friend aint gcd(const aint &a, const aint &b);
+  /**
+   * Extended Euclid's algorithm. As the aints are unsigned, the Bezout
+   * identity is given as a * s - b * t = g, with 0 < s <= b / g and
+   * t < a / g (s = 1 and t = 0 when b is zero).
+   * @return g = gcd(a, b)
+   * @throw std::invalid_argument Thrown if a is zero
+   */
+  friend aint xgcd(const aint &a, const aint &b, aint &s, aint &t);
+  /**
+   * @return The inverse x of a modulo m, with 0 <= x < m and a * x = 1 (mod m)
+   * @throw std::invalid_argument Thrown if m is zero or if a and m are not
+   * coprime
+   */
+  friend aint modinv(const aint &a, const aint &m);
+  /**
+   * @return The integer square root of a, floor(sqrt(a))
+   */
+  friend aint isqrt(const aint &a);
+  /**
+   * Newton's iteration, started from the root of the leading half of the bits
+   * so that the precision doubles at each level.
+   * @return The integer k-th root of a, floor(a^(1/k))
+   * @throw std::invalid_argument Thrown if k is zero
+   */
+  friend aint iroot(const aint &a, unsigned k);
+  /**
+   * Rejects most non-squares from their residues modulo 64, 63, 65 and 11
+   * before computing the square root.
+   * @return True if a is the square of an integer
+   */
+  friend bool is_perfect_square(const aint &a);
+  /**
+   * Computes the quotient and the remainder of a division in a single pass.
+   * The results may alias the operands.
+   * @param a The dividend
+   * @param b The divisor
+   * @param q Receives a / b
+   * @param r Receives a % b
+   * @throw std::invalid_argument Thrown if the divisor is zero
+   */
+  friend void divmod(const aint &a, const aint &b, aint &q, aint &r);
+  /**
+   * Computes r += a * b. Small products are accumulated row by row in the
+   * storage of `r`, without any temporary.
+   * @param r The accumulator, which may alias the operands
+   */
+  friend void addmul(aint &r, const aint &a, const aint &b);
+  /**
+   * Computes r -= a * b.
+   * @param r The accumulator, which may alias the operands
+   * @throw std::invalid_argument Thrown if a * b is higher than r, which is
+   * left unchanged
+   */
+  friend void submul(aint &r, const aint &a, const aint &b);
+  /**
+   * Computes r += (a * b) << offset.
+   * @param r The accumulator, which may alias the operands
+   * @param offset The shift of the product, in bits
+   */
+  friend void mul_add_shifted(aint &r, const aint &a, const aint &b,
+                              size_t offset);
+
+  /**
+   * Writes the blocks of the aint as they are in memory, after a header giving
+   * their width and number.
+   */
+  friend void serialize(const aint &a, std::ostream &o);
+  /**
+   * Reads an aint written by serialize(const aint &, std::ostream &), copying
+   * its blocks directly.
+   * @throw std::invalid_argument Thrown if the data is truncated or was
+   * written with another block width
+   */
+  friend aint deserialize(std::istream &i);
+
+  friend class montgomery_ctx;
+  friend class aint_view;
+  template <size_t Bits> friend class faint;
   friend std::ostream &operator<<(std::ostream &o, const aint &ai);
   friend std::istream &operator>>(std::istream &i, aint &ai);
 
@@ -159,4 +501,48 @@ public:
 #endif
 };
 
+aint operator+(const aint &a, aint &&b);
+aint operator+(aint &&a, aint &&b);
+aint operator-(const aint &a, aint &&b);
+aint operator-(aint &&a, aint &&b);
+aint operator&(const aint &a, aint &&b);
+aint operator&(aint &&a, aint &&b);
+aint operator|(const aint &a, aint &&b);
+aint operator|(aint &&a, aint &&b);
+aint operator^(const aint &a, aint &&b);
+aint operator^(aint &&a, aint &&b);
+aint square(const aint &a);
+aint gcd(const aint &a, const aint &b);
+aint xgcd(const aint &a, const aint &b, aint &s, aint &t);
+aint modinv(const aint &a, const aint &m);
+aint isqrt(const aint &a);
+aint iroot(const aint &a, unsigned k);
+bool is_perfect_square(const aint &a);
+void divmod(const aint &a, const aint &b, aint &q, aint &r);
+void addmul(aint &r, const aint &a, const aint &b);
+void submul(aint &r, const aint &a, const aint &b);
+void mul_add_shifted(aint &r, const aint &a, const aint &b, size_t offset);
+void serialize(const aint &a, std::ostream &o);
+aint deserialize(std::istream &i);
+
+/**
+ * Computes n! as (n/2)!^2 times the prime swing of n, a product of prime
+ * powers, which is then squared and multiplied with balanced operands.
+ */
+aint factorial(block_t n);
+/**
+ * @return The binomial coefficient n! / (k! (n - k)!), 0 if k > n
+ */
+aint binomial(block_t n, block_t k);
+/**
+ * @return The product of the primes lower than or equal to n
+ */
+aint primorial(block_t n);
+
+template <typename Iterator>
+aint aint::product(Iterator first, Iterator last) {
+  std::vector<aint> factors(first, last);
+  return aint::product_tree(factors);
+}
+
 #endif // LAB_AINT_AINT_H_
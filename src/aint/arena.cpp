@@ -0,0 +1,17 @@
+#include "arena.hpp"
+
+aint_resource_scope::aint_resource_scope(
+    std::pmr::memory_resource *resource) noexcept {
+  this->previous_ = aint::set_default_resource(resource);
+}
+
+aint_resource_scope::~aint_resource_scope() {
+  aint::set_default_resource(this->previous_);
+}
+
+aint_arena::aint_arena(size_t initial_size)
+    : resource_(initial_size), scope_(&this->resource_) {}
+
+std::pmr::memory_resource *aint_arena::resource() noexcept {
+  return &this->resource_;
+}
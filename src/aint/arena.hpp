@@ -0,0 +1,52 @@
+#ifndef LAB_AINT_ARENA_H_
+#define LAB_AINT_ARENA_H_
+#include "aint.hpp"
+#include <memory_resource>
+
+/**
+ * Sets the default memory resource of the aints constructed by the calling
+ * thread until the end of the scope.
+ * @see aint::set_default_resource(std::pmr::memory_resource *)
+ */
+class aint_resource_scope {
+  std::pmr::memory_resource *previous_;
+
+public:
+  /**
+   * @param resource The resource, `nullptr` for the C heap
+   */
+  explicit aint_resource_scope(std::pmr::memory_resource *resource) noexcept;
+  ~aint_resource_scope();
+  aint_resource_scope(const aint_resource_scope &) = delete;
+  aint_resource_scope &operator=(const aint_resource_scope &) = delete;
+};
+
+/**
+ * Monotonic arena providing the blocks of the aints constructed by the calling
+ * thread during its lifetime, temporaries included. Freed blocks are not
+ * reused, all of them being released at once when the arena is destroyed.
+ *
+ * @note
+ * The aints using the arena must be destroyed before it. A result is kept by
+ * assigning it to an aint constructed outside of the arena, which copies its
+ * blocks.
+ */
+class aint_arena {
+  std::pmr::monotonic_buffer_resource resource_;
+  aint_resource_scope scope_;
+
+public:
+  /**
+   * @param initial_size The size of the first buffer of the arena, in bytes
+   */
+  explicit aint_arena(size_t initial_size = 1 << 16);
+  aint_arena(const aint_arena &) = delete;
+  aint_arena &operator=(const aint_arena &) = delete;
+
+  /**
+   * @return The resource of the arena
+   */
+  std::pmr::memory_resource *resource() noexcept;
+};
+
+#endif // LAB_AINT_ARENA_H_
@@ -0,0 +1,149 @@
+#include "batch.hpp"
+#include "view.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+aint_batch::aint_batch(size_t count, size_t blocks)
+    : count_(count), blocks_(blocks), data_(count * blocks, 0),
+      carries_(count, 0) {}
+
+size_t aint_batch::count() const noexcept { return this->count_; }
+
+size_t aint_batch::blocks() const noexcept { return this->blocks_; }
+
+block_t *aint_batch::column(size_t block) noexcept {
+  return this->data_.data() + block * this->count_;
+}
+
+const block_t *aint_batch::column(size_t block) const noexcept {
+  return this->data_.data() + block * this->count_;
+}
+
+void aint_batch::check_shape(const aint_batch &other) const {
+  if (this->count_ != other.count_ || this->blocks_ != other.blocks_) {
+    throw std::invalid_argument("Batches of different shapes");
+  }
+}
+
+aint aint_batch::gather(size_t index) const {
+  std::vector<block_t> blocks(this->blocks_);
+  for (size_t j = 0; j < this->blocks_; j++) {
+    blocks[j] = this->column(j)[index];
+  }
+  return aint_view(blocks.data(), blocks.size());
+}
+
+void aint_batch::scatter(size_t index, const aint &value) {
+  if (value.size() > this->blocks_) {
+    throw std::invalid_argument("Integer too large for the batch");
+  }
+  const block_t *blocks = aint_view(value).data();
+  for (size_t j = 0; j < this->blocks_; j++) {
+    this->column(j)[index] = j < value.size() ? blocks[j] : 0;
+  }
+}
+
+/**
+ * Vector of 128 bits of blocks, and of signed blocks for the comparison
+ * masks, one lane per integer of the batch.
+ */
+typedef block_t block_vector_t __attribute__((vector_size(16)));
+typedef std::make_signed<block_t>::type sblock_t;
+typedef sblock_t sblock_vector_t __attribute__((vector_size(16)));
+static const size_t VECTOR_BLOCKS = sizeof(block_vector_t) / sizeof(block_t);
+
+/**
+ * The integers are added a vector of them at a time, their carries staying in
+ * a vector. The carries are computed with comparisons rather than
+ * double-blocks, which the vector units do not provide.
+ */
+bool aint_batch::add(const aint_batch &other) {
+  this->check_shape(other);
+  size_t i = 0;
+  block_vector_t overflow = {};
+  for (; i + VECTOR_BLOCKS <= this->count_; i += VECTOR_BLOCKS) {
+    block_vector_t carry = {};
+    for (size_t j = 0; j < this->blocks_; j++) {
+      block_vector_t a, b;
+      std::memcpy(&a, this->column(j) + i, sizeof(a));
+      std::memcpy(&b, other.column(j) + i, sizeof(b));
+      a += b;
+      // A comparison gives -1 in the lanes where it holds.
+      block_vector_t out = (block_vector_t)(-(a < b));
+      a += carry;
+      carry = out | (block_vector_t)(-(a < carry));
+      std::memcpy(this->column(j) + i, &a, sizeof(a));
+    }
+    overflow |= carry;
+  }
+  bool overflowed = false;
+  for (size_t k = 0; k < VECTOR_BLOCKS; k++) {
+    overflowed |= overflow[k] != 0;
+  }
+  for (; i < this->count_; i++) {
+    block_t carry = 0;
+    for (size_t j = 0; j < this->blocks_; j++) {
+      block_t a = this->column(j)[i] + other.column(j)[i];
+      block_t out = a < other.column(j)[i];
+      a += carry;
+      carry = out | (a < carry);
+      this->column(j)[i] = a;
+    }
+    overflowed |= carry != 0;
+  }
+  return overflowed;
+}
+
+/**
+ * The carries of the integers are kept in aint_batch::carries_ so that the
+ * loop over a column stays vectorizable with 32 bits blocks.
+ */
+bool aint_batch::mul_small(block_t u) {
+  block_t *carries = this->carries_.data();
+  std::fill(carries, carries + this->count_, 0);
+  for (size_t j = 0; j < this->blocks_; j++) {
+    block_t *a = this->column(j);
+    for (size_t i = 0; i < this->count_; i++) {
+      dblock_t product = static_cast<dblock_t>(a[i]) * u + carries[i];
+      a[i] = static_cast<block_t>(product);
+      carries[i] = static_cast<block_t>(product >> BLOCK_WIDTH);
+    }
+  }
+  block_t overflow = 0;
+  for (size_t i = 0; i < this->count_; i++) {
+    overflow |= carries[i];
+  }
+  return overflow != 0;
+}
+
+/**
+ * The columns are compared from the most significant one, the order of an
+ * integer being kept once a block differs.
+ */
+void aint_batch::compare(const aint_batch &other, int *result) const {
+  this->check_shape(other);
+  size_t i = 0;
+  for (; i + VECTOR_BLOCKS <= this->count_; i += VECTOR_BLOCKS) {
+    sblock_vector_t order = {};
+    for (size_t j = this->blocks_; j > 0; j--) {
+      block_vector_t a, b;
+      std::memcpy(&a, this->column(j - 1) + i, sizeof(a));
+      std::memcpy(&b, other.column(j - 1) + i, sizeof(b));
+      sblock_vector_t block_order = (a < b) - (a > b);
+      order |= block_order & (order == 0);
+    }
+    for (size_t k = 0; k < VECTOR_BLOCKS; k++) {
+      result[i + k] = static_cast<int>(order[k]);
+    }
+  }
+  for (; i < this->count_; i++) {
+    int order = 0;
+    for (size_t j = this->blocks_; j > 0 && order == 0; j--) {
+      block_t a = this->column(j - 1)[i], b = other.column(j - 1)[i];
+      order = (a > b) - (a < b);
+    }
+    result[i] = order;
+  }
+}
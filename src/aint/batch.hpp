@@ -0,0 +1,87 @@
+#ifndef LAB_AINT_BATCH_H_
+#define LAB_AINT_BATCH_H_
+#include "aint.hpp"
+#include <vector>
+
+/**
+ * Batch of `count` small unsigned integers of `blocks` blocks each, stored as
+ * a structure of arrays: block j of every number is contiguous, in a column.
+ *
+ * @details
+ * The operations apply to the whole batch, a column at a time. Their inner
+ * loops run over the numbers of the batch without any branch, so that the
+ * compiler vectorizes them, each lane carrying the state of one number.
+ * The numbers have a fixed width: results are computed modulo
+ * 2^(BLOCK_WIDTH * blocks), and the operations report whether a number
+ * overflowed.
+ */
+class aint_batch {
+  size_t count_;
+  size_t blocks_;
+  /**
+   * The columns, one after the other.
+   */
+  std::vector<block_t> data_;
+  /**
+   * Carries of the numbers, kept between operations to avoid allocations.
+   */
+  std::vector<block_t> carries_;
+
+  block_t *column(size_t block) noexcept;
+  const block_t *column(size_t block) const noexcept;
+  /**
+   * @throw std::invalid_argument Thrown if the other batch has another shape
+   */
+  void check_shape(const aint_batch &other) const;
+
+public:
+  /**
+   * Constructs a batch of zeros.
+   * @param count The number of integers
+   * @param blocks The number of blocks of each integer
+   */
+  aint_batch(size_t count, size_t blocks);
+
+  /**
+   * @return The number of integers of the batch
+   */
+  size_t count() const noexcept;
+  /**
+   * @return The number of blocks of each integer
+   */
+  size_t blocks() const noexcept;
+
+  /**
+   * @return The integer at `index`, its blocks being gathered from the columns
+   */
+  aint gather(size_t index) const;
+  /**
+   * Scatters the blocks of an aint into the columns, at `index`.
+   * @throw std::invalid_argument Thrown if the aint has more blocks than the
+   * integers of the batch
+   */
+  void scatter(size_t index, const aint &value);
+
+  /**
+   * Adds the integers of another batch of the same shape to the integers of
+   * this batch.
+   * @return True if the sum of some integer overflowed
+   * @throw std::invalid_argument Thrown if the batches have different shapes
+   */
+  bool add(const aint_batch &other);
+  /**
+   * Multiplies every integer of the batch by a block.
+   * @return True if the product of some integer overflowed
+   */
+  bool mul_small(block_t u);
+  /**
+   * Compares the integers of two batches of the same shape.
+   * @param result Receives, for each integer, a negative value, zero or a
+   * positive value if it is lower than, equal to or greater than the integer
+   * of the other batch
+   * @throw std::invalid_argument Thrown if the batches have different shapes
+   */
+  void compare(const aint_batch &other, int *result) const;
+};
+
+#endif // LAB_AINT_BATCH_H_
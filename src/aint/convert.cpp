@@ -0,0 +1,469 @@
+#include "aint.hpp"
+#include "arena.hpp"
+#include "mpn.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define AINT_HAVE_SSE2 1
+#else
+#define AINT_HAVE_SSE2 0
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define AINT_HAVE_AVX2 1
+#else
+#define AINT_HAVE_AVX2 0
+#endif
+
+/**
+ * Largest power of ten fitting in a block, 10^9 or 10^19, used as the base of
+ * the decimal conversions.
+ */
+#if AINT_BLOCK_WIDTH == 64
+static const block_t DECIMAL_CHUNK = 10000000000000000000u;
+static const size_t DECIMAL_CHUNK_DIGITS = 19;
+#else
+static const block_t DECIMAL_CHUNK = 1000000000;
+static const size_t DECIMAL_CHUNK_DIGITS = 9;
+#endif
+/**
+ * Sizes (in blocks for rendering, in digits for parsing) under which the
+ * decimal conversions use the quadratic algorithms.
+ */
+static const size_t DECIMAL_RENDER_BASECASE_SIZE = 32;
+static const size_t DECIMAL_PARSE_BASECASE_LENGTH = 64 * DECIMAL_CHUNK_DIGITS;
+
+static const char DIGITS[] = "0123456789abcdef";
+
+/**
+ * The powers DECIMAL_CHUNK^(2^k) are computed once and shared by every
+ * conversion.
+ * @return Pointers to the `count` first powers
+ */
+static std::vector<const aint *> decimal_powers(size_t count) {
+  static std::deque<aint> powers;
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
+  // The cache outlives any arena the caller may be using.
+  aint_resource_scope heap(nullptr);
+  if (powers.empty()) {
+    powers.emplace_back(DECIMAL_CHUNK);
+  }
+  while (powers.size() < count) {
+    powers.push_back(powers.back() * powers.back());
+  }
+  // Elements of a deque are never moved by push_back.
+  std::vector<const aint *> result;
+  for (size_t k = 0; k < count; k++) {
+    result.push_back(&powers[k]);
+  }
+  return result;
+}
+
+/**
+ * @return The smallest level such that DECIMAL_CHUNK_DIGITS * 2^level >=
+ * digit_count
+ */
+static size_t decimal_level(size_t digit_count) {
+  size_t level = 0;
+  while ((DECIMAL_CHUNK_DIGITS << level) < digit_count) {
+    level++;
+  }
+  return level;
+}
+
+/**
+ * @return The value of a digit in the given base, or `base` if the character
+ * is not a valid digit
+ */
+static unsigned digit_value(char c, unsigned base) {
+  unsigned value = base;
+  if (c >= '0' && c <= '9') {
+    value = static_cast<unsigned>(c - '0');
+  } else if (c >= 'a' && c <= 'f') {
+    value = static_cast<unsigned>(c - 'a') + 10;
+  } else if (c >= 'A' && c <= 'F') {
+    value = static_cast<unsigned>(c - 'A') + 10;
+  }
+  return value < base ? value : base;
+}
+
+/**
+ * Packs a little-endian binary representation into blocks, 32 or 16
+ * characters at a time by comparing them with '1' and gathering the byte masks.
+ * @param r Receives the `(length + BLOCK_WIDTH - 1) / BLOCK_WIDTH` blocks
+ * @return False if a character is neither '0' nor '1'
+ */
+static bool pack_binary(block_t *r, const char *str, size_t length) {
+  size_t i = 0;
+#if AINT_HAVE_AVX2
+  for (; i + 32 <= length; i += 32) {
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + i));
+    __m256i ones = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('1'));
+    __m256i zeros = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('0'));
+    if (_mm256_movemask_epi8(_mm256_or_si256(ones, zeros)) != -1) {
+      return false;
+    }
+    block_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(ones));
+    if (i % BLOCK_WIDTH == 0) {
+      r[i / BLOCK_WIDTH] = bits;
+    } else {
+      r[i / BLOCK_WIDTH] |= bits << (i % BLOCK_WIDTH);
+    }
+  }
+#endif
+#if AINT_HAVE_SSE2
+  for (; i + 16 <= length; i += 16) {
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str + i));
+    __m128i ones = _mm_cmpeq_epi8(c, _mm_set1_epi8('1'));
+    __m128i zeros = _mm_cmpeq_epi8(c, _mm_set1_epi8('0'));
+    if (_mm_movemask_epi8(_mm_or_si128(ones, zeros)) != 0xffff) {
+      return false;
+    }
+    block_t bits = static_cast<block_t>(_mm_movemask_epi8(ones));
+    if (i % BLOCK_WIDTH == 0) {
+      r[i / BLOCK_WIDTH] = bits;
+    } else {
+      r[i / BLOCK_WIDTH] |= bits << (i % BLOCK_WIDTH);
+    }
+  }
+#endif
+  for (; i < length; i++) {
+    if (str[i] != '0' && str[i] != '1') {
+      return false;
+    }
+    if (i % BLOCK_WIDTH == 0) {
+      r[i / BLOCK_WIDTH] = 0;
+    }
+    r[i / BLOCK_WIDTH] |= static_cast<block_t>(str[i] - '0')
+                          << (i % BLOCK_WIDTH);
+  }
+  return true;
+}
+
+#if AINT_HAVE_SSE2
+/**
+ * Converts 16 hexadecimal digits, most significant first, to their value.
+ * @return False if a character is not a hexadecimal digit
+ */
+static bool pack_hex_group(const char *str, uint64_t &value) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str));
+  __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i is_digit =
+      _mm_cmpeq_epi8(_mm_subs_epu8(digit, _mm_set1_epi8(9)), zero);
+  __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)),
+                                _mm_set1_epi8('a'));
+  __m128i is_letter =
+      _mm_cmpeq_epi8(_mm_subs_epu8(letter, _mm_set1_epi8(5)), zero);
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff) {
+    return false;
+  }
+  __m128i nibbles = _mm_or_si128(
+      _mm_and_si128(is_digit, digit),
+      _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+  // Each byte receives a pair of nibbles, the first one being the high nibble.
+  __m128i pairs =
+      _mm_or_si128(_mm_slli_epi16(nibbles, 4), _mm_srli_epi16(nibbles, 8));
+  __m128i bytes =
+      _mm_packus_epi16(_mm_and_si128(pairs, _mm_set1_epi16(0xff)), zero);
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(&value), bytes);
+  value = __builtin_bswap64(value);
+  return true;
+}
+#endif
+
+/**
+ * Packs a hexadecimal representation, most significant digit first, into
+ * blocks, 16 digits at a time starting from the least significant ones.
+ * @param r Receives the `(4 * length + BLOCK_WIDTH - 1) / BLOCK_WIDTH` blocks
+ * @return False if a character is not a hexadecimal digit
+ */
+static bool pack_hex(block_t *r, const char *str, size_t length) {
+  size_t i = 0;
+#if AINT_HAVE_SSE2
+  for (; i + 16 <= length; i += 16) {
+    uint64_t value;
+    if (!pack_hex_group(str + length - i - 16, value)) {
+      return false;
+    }
+    block_t *target = r + 4 * i / BLOCK_WIDTH;
+#if BLOCK_WIDTH == 64
+    target[0] = value;
+#else
+    target[0] = static_cast<block_t>(value);
+    target[1] = static_cast<block_t>(value >> 32);
+#endif
+  }
+#endif
+  for (; i < length; i++) {
+    unsigned value = digit_value(str[length - 1 - i], 16);
+    if (value == 16) {
+      return false;
+    }
+    size_t bit_index = 4 * i;
+    if (bit_index % BLOCK_WIDTH == 0) {
+      r[bit_index / BLOCK_WIDTH] = 0;
+    }
+    r[bit_index / BLOCK_WIDTH] |= static_cast<block_t>(value)
+                                  << (bit_index % BLOCK_WIDTH);
+  }
+  return true;
+}
+
+aint aint::from_string(const char *str, unsigned base) {
+  aint a;
+  a.parse(str, std::strlen(str), base);
+  return a;
+}
+
+void aint::parse(const char *str, size_t length, unsigned base) {
+  if (base != 2 && base != 10 && base != 16) {
+    throw std::invalid_argument("base");
+  }
+  if (length == 0) {
+    this->resize(0);
+    return;
+  }
+  if (base == 10) {
+    for (size_t i = 0; i < length; i++) {
+      if (digit_value(str[i], 10) == 10) {
+        this->resize(0);
+        throw std::invalid_argument("str");
+      }
+    }
+    this->parse_decimal(str, length);
+    return;
+  }
+
+  size_t block_count =
+      ((base == 2 ? 1 : 4) * length + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+  this->resize(block_count);
+  bool valid = base == 2 ? pack_binary(this->blocks_, str, length)
+                         : pack_hex(this->blocks_, str, length);
+  if (!valid) {
+    this->resize(0);
+    throw std::invalid_argument("str");
+  }
+  this->size_ = block_count;
+  this->refresh_size();
+}
+
+void aint::parse_decimal(const char *str, size_t length) {
+  if (length > DECIMAL_PARSE_BASECASE_LENGTH) {
+    // length is in (d * 2^(level-1), d * 2^level], d being
+    // DECIMAL_CHUNK_DIGITS, the lower half taking the d * 2^(level-1) last
+    // digits.
+    size_t level = decimal_level(length);
+    size_t low_length = DECIMAL_CHUNK_DIGITS << (level - 1);
+    aint high, low;
+    high.parse_decimal(str, length - low_length);
+    low.parse_decimal(str + length - low_length, low_length);
+    *this = high * *decimal_powers(level)[level - 1];
+    *this += low;
+    return;
+  }
+
+  // 10 < 2^(10/3), the capacity covers 10^length. The blocks kept by the
+  // resize are cleared, the accumulation starting from zero.
+  this->resize((length * 10 / 3) / BLOCK_WIDTH + 2);
+  std::fill(this->blocks_, this->blocks_ + this->capacity(), 0);
+  size_t n = 0;
+  size_t chunk_length = length % DECIMAL_CHUNK_DIGITS;
+  if (chunk_length == 0) {
+    chunk_length = DECIMAL_CHUNK_DIGITS;
+  }
+  for (size_t i = 0; i < length; i += chunk_length) {
+    if (i != 0) {
+      chunk_length = DECIMAL_CHUNK_DIGITS;
+    }
+    block_t chunk = 0, multiplier = 1;
+    for (size_t j = i; j < i + chunk_length; j++) {
+      chunk = chunk * 10 + static_cast<block_t>(str[j] - '0');
+      multiplier *= 10;
+    }
+    // The carry is lower than the multiplier, adding the chunk cannot overflow.
+    block_t carry = mpn::mul_1(this->blocks_, this->blocks_, n, multiplier);
+    carry += mpn::add_1(this->blocks_, this->blocks_, n, chunk);
+    if (carry != 0) {
+      this->blocks_[n] = carry;
+      n++;
+    }
+  }
+  this->size_ = n;
+}
+
+void aint::render_decimal(const aint &a, size_t level,
+                          const aint *const *powers, char *out) {
+  size_t width = DECIMAL_CHUNK_DIGITS << level;
+  if (level > 0 && a.size() > DECIMAL_RENDER_BASECASE_SIZE) {
+    aint quotient, rest;
+    divmod(a, *powers[level - 1], quotient, rest);
+    aint::render_decimal(quotient, level - 1, powers, out);
+    aint::render_decimal(rest, level - 1, powers, out + width / 2);
+    return;
+  }
+
+  std::vector<block_t> rest(a.blocks_, a.blocks_ + a.size());
+  size_t n = rest.size();
+  char *digit = out + width;
+  while (n > 0) {
+    block_t chunk = mpn::divrem_1(rest.data(), rest.data(), n, DECIMAL_CHUNK);
+    n = mpn::normalized_size(rest.data(), n);
+    for (size_t i = 0; i < DECIMAL_CHUNK_DIGITS; i++) {
+      digit--;
+      *digit = DIGITS[chunk % 10];
+      chunk /= 10;
+    }
+  }
+  std::fill(out, digit, '0');
+}
+
+char *aint::to_string(unsigned base) const {
+  if (base != 2 && base != 10 && base != 16) {
+    throw std::invalid_argument("base");
+  }
+  if (this->zero()) {
+    auto render = static_cast<char *>(calloc(2, sizeof(char)));
+    if (render == nullptr) {
+      throw std::bad_alloc();
+    }
+    render[0] = '0';
+    render[1] = '\0';
+    return render;
+  }
+
+  if (base == 10) {
+    // log10(2) < 0.30103, the width covers the 2^(BLOCK_WIDTH * size) bound.
+    size_t level = decimal_level(this->size() * BLOCK_WIDTH * 30103 / 100000 +
+                                 1);
+    size_t width = DECIMAL_CHUNK_DIGITS << level;
+    auto render = static_cast<char *>(calloc(width + 1, sizeof(char)));
+    if (render == nullptr) {
+      throw std::bad_alloc();
+    }
+    aint::render_decimal(*this, level, decimal_powers(level).data(), render);
+    size_t leading_zeros = 0;
+    while (render[leading_zeros] == '0') {
+      leading_zeros++;
+    }
+    std::memmove(render, render + leading_zeros, width - leading_zeros + 1);
+    return render;
+  }
+
+  if (base == 16) {
+    const size_t block_digits = BLOCK_WIDTH / 4;
+    auto nibble = [this, block_digits](size_t i) {
+      return static_cast<unsigned>(
+          (this->blocks_[i / block_digits] >> (4 * (i % block_digits))) & 0xf);
+    };
+    size_t digit_count = this->size() * block_digits;
+    while (nibble(digit_count - 1) == 0) {
+      digit_count--;
+    }
+    auto render = static_cast<char *>(calloc(digit_count + 1, sizeof(char)));
+    if (render == nullptr) {
+      throw std::bad_alloc();
+    }
+    for (size_t i = 0; i < digit_count; i++) {
+      render[digit_count - 1 - i] = DIGITS[nibble(i)];
+    }
+    return render;
+  }
+
+  auto render =
+      static_cast<char *>(calloc(BLOCK_WIDTH * this->size() + 1, sizeof(char)));
+  if (render == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  for (size_t block_index = 0; block_index < this->size(); block_index++) {
+    block_t block = this->blocks_[block_index];
+    for (int bit_index = 0; bit_index < BLOCK_WIDTH; bit_index++) {
+      render[block_index * BLOCK_WIDTH + bit_index] = block % 2 ? '1' : '0';
+      block /= 2;
+      // Places the string end character.
+      if (block_index == this->size() - 1 && block == 0) {
+        render[block_index * BLOCK_WIDTH + bit_index + 1] = '\0';
+        break;
+      }
+    }
+  }
+  return render;
+}
+
+std::istream &operator>>(std::istream &i, aint &ai) {
+  std::istream::sentry sentry(i, true);
+  if (!sentry) {
+    return i;
+  }
+  // The line is pulled in chunks, whole blocks being packed as soon as they are
+  // read. The characters of an incomplete block wait at the buffer start.
+  const size_t chunk_length = 4096 * BLOCK_WIDTH;
+  std::vector<char> buffer(BLOCK_WIDTH + chunk_length + 1);
+  char *data = buffer.data();
+  size_t pending = 0, block_count = 0;
+  bool line_end = false, valid = true;
+  std::fill(ai.blocks_, ai.blocks_ + ai.size(), 0);
+  ai.size_ = 0;
+  while (!line_end) {
+    i.getline(data + pending, static_cast<std::streamsize>(chunk_length + 1));
+    size_t length = pending + static_cast<size_t>(i.gcount());
+    if (i.eof()) {
+      line_end = true;
+    } else if (i.fail()) {
+      // The chunk is full, the line goes on.
+      i.clear();
+    } else {
+      // The delimiter has been extracted but not stored.
+      length--;
+      line_end = true;
+    }
+
+    size_t packed_length = line_end ? length : length - length % BLOCK_WIDTH;
+    size_t needed = block_count + chunk_length / BLOCK_WIDTH + 1;
+    if (ai.capacity() < needed) {
+      ai.reserve(std::max(needed, 2 * ai.capacity()));
+    }
+    if (!pack_binary(ai.blocks_ + block_count, data, packed_length)) {
+      // Spaces are skipped, the chunk is only compacted when packing fails.
+      length = static_cast<size_t>(
+          std::remove_if(data, data + length,
+                         [](char c) {
+                           return std::isspace(static_cast<unsigned char>(c));
+                         }) -
+          data);
+      packed_length = line_end ? length : length - length % BLOCK_WIDTH;
+      if (!pack_binary(ai.blocks_ + block_count, data, packed_length)) {
+        valid = false;
+        break;
+      }
+    }
+    block_count += (packed_length + BLOCK_WIDTH - 1) / BLOCK_WIDTH;
+    // Keeps the packed blocks when reserving.
+    ai.size_ = block_count;
+    pending = length - packed_length;
+    std::memmove(data, data + packed_length, pending);
+  }
+
+  if (!valid) {
+    if (!line_end) {
+      i.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    ai.resize(0);
+    i.setstate(std::ios::failbit);
+    return i;
+  }
+  // A failed packing attempt may have left blocks above the packed ones.
+  std::fill(ai.blocks_ + block_count, ai.blocks_ + ai.capacity(), 0);
+  ai.refresh_size();
+  return i;
+}
@@ -0,0 +1,251 @@
+#include "mpn.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace mpn {
+
+/**
+ * @return The number of leading zero bits of a non-zero block
+ */
+static unsigned count_leading_zeros(block_t u) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_clzll(u)) - (64 - BLOCK_WIDTH);
+#else
+  unsigned count = 0;
+  for (block_t mask = static_cast<block_t>(1) << (BLOCK_WIDTH - 1);
+       (u & mask) == 0; mask >>= 1) {
+    count++;
+  }
+  return count;
+#endif
+}
+
+block_t divrem_1(block_t *q, const block_t *a, size_t n, block_t u) {
+  dblock_t rest = 0;
+  for (size_t i = n; i > 0; i--) {
+    dblock_t current = (rest << BLOCK_WIDTH) | a[i - 1];
+    q[i - 1] = static_cast<block_t>(current / u);
+    rest = current % u;
+  }
+  return static_cast<block_t>(rest);
+}
+
+size_t divrem_itch(size_t an, size_t dn) { return an + 1 + dn; }
+
+/**
+ * Knuth's algorithm D. Both operands are first shifted so that the most
+ * significant bit of the divisor is set, which guarantees each estimated
+ * quotient block to be at most two above the correct one.
+ */
+static void divrem_basecase(block_t *q, block_t *r, const block_t *a,
+                            size_t an, const block_t *d, size_t dn,
+                            block_t *scratch) {
+  if (dn == 1) {
+    r[0] = divrem_1(q, a, an, d[0]);
+    return;
+  }
+  unsigned shift = count_leading_zeros(d[dn - 1]);
+  block_t *u = scratch, *v = scratch + an + 1;
+  if (shift != 0) {
+    u[an] = lshift(u, a, an, shift);
+    lshift(v, d, dn, shift);
+  } else {
+    std::copy(a, a + an, u);
+    u[an] = 0;
+    std::copy(d, d + dn, v);
+  }
+
+  const block_t v_high = v[dn - 1], v_next = v[dn - 2];
+  for (size_t j = an - dn + 1; j > 0; j--) {
+    block_t *window = u + j - 1;
+    // Estimates the quotient block from the two most significant blocks.
+    dblock_t numerator =
+        (static_cast<dblock_t>(window[dn]) << BLOCK_WIDTH) | window[dn - 1];
+    dblock_t q_estimate = numerator / v_high;
+    dblock_t r_estimate = numerator % v_high;
+    while (q_estimate > BLOCK_MAX ||
+           q_estimate * v_next >
+               ((r_estimate << BLOCK_WIDTH) | window[dn - 2])) {
+      q_estimate--;
+      r_estimate += v_high;
+      if (r_estimate > BLOCK_MAX) {
+        break;
+      }
+    }
+    // Multiplies and subtracts, adding back once if the estimate was too high.
+    block_t borrow =
+        submul_1(window, v, dn, static_cast<block_t>(q_estimate));
+    block_t top = window[dn];
+    window[dn] = top - borrow;
+    if (top < borrow) {
+      q_estimate--;
+      window[dn] += add_n(window, window, v, dn);
+    }
+    q[j - 1] = static_cast<block_t>(q_estimate);
+  }
+
+  if (shift != 0) {
+    rshift(r, u, dn, shift);
+  } else {
+    std::copy(u, u + dn, r);
+  }
+}
+
+/**
+ * Computes r = a * b for operands of any size, zero included. The result has
+ * `an + bn` blocks.
+ */
+static void mul_any(block_t *r, const block_t *a, size_t an, const block_t *b,
+                    size_t bn) {
+  size_t rn = an + bn;
+  an = normalized_size(a, an);
+  bn = normalized_size(b, bn);
+  if (an == 0 || bn == 0) {
+    std::fill(r, r + rn, 0);
+    return;
+  }
+  std::fill(r + an + bn, r + rn, 0);
+  if (an >= bn) {
+    mul(r, a, an, b, bn);
+  } else {
+    mul(r, b, bn, a, an);
+  }
+}
+
+/**
+ * Computes v = (B^2n - 1) / d for a normalized divisor (most significant bit
+ * set) of `n` blocks. The reciprocal has `n + 1` blocks.
+ *
+ * @details
+ * The reciprocal vh of the `h` most significant blocks of `d` gives a first
+ * approximation x0 = vh * B^(n-h), refined by one Newton iteration
+ * x1 = x0 + x0 * (B^2n - d * x0) / B^2n. The few units of error left are then
+ * corrected, keeping the reciprocal exact at every recursion level.
+ */
+static void invert(block_t *v, const block_t *d, size_t n) {
+  if (n < std::max<size_t>(thresholds.div_newton, 2)) {
+    std::vector<block_t> ones(2 * n, BLOCK_MAX), rest(n),
+        scratch(divrem_itch(2 * n, n));
+    divrem_basecase(v, rest.data(), ones.data(), 2 * n, d, n, scratch.data());
+    return;
+  }
+  size_t h = (n + 1) / 2, l = n - h;
+  std::vector<block_t> vh(h + 1), e(n + h + 1), correction(n + 2 * h + 1),
+      product(2 * n + 1);
+  invert(vh.data(), d + l, h);
+
+  // B^2n - d * x0 = (B^(n+h) - d * vh) * B^l, where d * vh < 2 * B^(n+h).
+  mul_any(e.data(), d, n, vh.data(), h + 1);
+  bool too_high = e[n + h] != 0;
+  if (too_high) {
+    e[n + h] = 0;
+  } else {
+    for (size_t i = 0; i < n + h; i++) {
+      e[i] = ~e[i];
+    }
+    add_1(e.data(), e.data(), n + h, 1);
+  }
+  // x0 * e * B^l / B^2n = vh * e / B^2h.
+  mul_any(correction.data(), vh.data(), h + 1, e.data(), n + h);
+  std::fill(v, v + l, 0);
+  std::copy(vh.begin(), vh.end(), v + l);
+  if (too_high) {
+    sub(v, v, n + 1, correction.data() + 2 * h, n + 1);
+    sub_1(v, v, n + 1, 1);
+  } else {
+    add(v, v, n + 1, correction.data() + 2 * h, n + 1);
+  }
+
+  // Corrects v until d * v <= B^2n - 1 < d * (v + 1).
+  mul_any(product.data(), d, n, v, n + 1);
+  while (product[2 * n] != 0) {
+    sub_1(v, v, n + 1, 1);
+    sub(product.data(), product.data(), 2 * n + 1, d, n);
+  }
+  block_t *rest = product.data();
+  for (size_t i = 0; i < 2 * n; i++) {
+    rest[i] = ~rest[i];
+  }
+  while (normalized_size(rest + n, n) != 0 || cmp(rest, d, n) >= 0) {
+    add_1(v, v, n + 1, 1);
+    sub(rest, rest, 2 * n, d, n);
+  }
+}
+
+/**
+ * Divides a number of `2n` blocks, whose upper half is lower than the
+ * normalized divisor `d`, using its reciprocal `v`. The quotient and the
+ * remainder have `n` blocks.
+ *
+ * @details
+ * The estimate (a / B^(n-1)) * v / B^(n+1) is never above the quotient and
+ * only a few units below.
+ */
+static void divrem_2n_by_n(block_t *q, block_t *r, const block_t *a,
+                           const block_t *d, const block_t *v, size_t n,
+                           block_t *scratch) {
+  block_t *estimate = scratch, *rest = scratch + 2 * n + 2;
+  mul_any(estimate, a + n - 1, n + 1, v, n + 1);
+  std::copy(estimate + n + 1, estimate + 2 * n + 1, q);
+  mul_any(rest, q, n, d, n);
+  sub_n(rest, a, rest, 2 * n);
+  while (normalized_size(rest + n, n) != 0 || cmp(rest, d, n) >= 0) {
+    add_1(q, q, n, 1);
+    sub(rest, rest, 2 * n, d, n);
+  }
+  std::copy(rest, rest + n, r);
+}
+
+/**
+ * Division by Newton reciprocal. The normalized dividend is cut into pieces of
+ * `dn` blocks, each step dividing the previous remainder followed by the next
+ * piece.
+ */
+static void divrem_newton(block_t *q, block_t *r, const block_t *a, size_t an,
+                          const block_t *d, size_t dn) {
+  unsigned shift = count_leading_zeros(d[dn - 1]);
+  size_t piece_count = (an + 1 + dn - 1) / dn;
+  std::vector<block_t> u(piece_count * dn, 0), v(dn), reciprocal(dn + 1),
+      quotient(piece_count * dn), window(2 * dn), scratch(4 * dn + 2);
+  if (shift != 0) {
+    u[an] = lshift(u.data(), a, an, shift);
+    lshift(v.data(), d, dn, shift);
+  } else {
+    std::copy(a, a + an, u.begin());
+    std::copy(d, d + dn, v.begin());
+  }
+  invert(reciprocal.data(), v.data(), dn);
+
+  // The upper half of the window holds the remainder of the previous step.
+  for (size_t i = piece_count; i > 0; i--) {
+    std::copy(u.begin() + (i - 1) * dn, u.begin() + i * dn, window.begin());
+    divrem_2n_by_n(quotient.data() + (i - 1) * dn, window.data() + dn,
+                   window.data(), v.data(), reciprocal.data(), dn,
+                   scratch.data());
+  }
+  std::copy(quotient.begin(), quotient.begin() + (an - dn + 1), q);
+  if (shift != 0) {
+    rshift(r, window.data() + dn, dn, shift);
+  } else {
+    std::copy(window.begin() + dn, window.end(), r);
+  }
+}
+
+void divrem(block_t *q, block_t *r, const block_t *a, size_t an,
+            const block_t *d, size_t dn, block_t *scratch) {
+  if (dn >= std::max<size_t>(thresholds.div_newton, 2) &&
+      an - dn >= thresholds.div_newton) {
+    divrem_newton(q, r, a, an, d, dn);
+  } else {
+    divrem_basecase(q, r, a, an, d, dn, scratch);
+  }
+}
+
+void divrem(block_t *q, block_t *r, const block_t *a, size_t an,
+            const block_t *d, size_t dn) {
+  std::unique_ptr<block_t[]> scratch(new block_t[divrem_itch(an, dn)]);
+  divrem(q, r, a, an, d, dn, scratch.get());
+}
+
+} // namespace mpn
@@ -0,0 +1,578 @@
+#ifndef LAB_AINT_FAINT_H_
+#define LAB_AINT_FAINT_H_
+#include "aint.hpp"
+#include "view.hpp"
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * Fixed-width unsigned integer of `Bits` bits, stored as Bits / BLOCK_WIDTH
+ * blocks inside the object.
+ *
+ * @details
+ * The operations are those of aint, computed modulo 2^Bits as with the
+ * built-in unsigned types: additions and multiplications wrap around and
+ * subtracting a higher number does not throw. Every loop runs over the whole
+ * fixed number of blocks, so that the compiler unrolls it and keeps small
+ * values in registers. All the operations are `constexpr`, except the
+ * conversions to and from aint.
+ *
+ * @note
+ * A faint is viewed as an aint operand without copy with faint::view().
+ */
+template <size_t Bits> class faint {
+  static_assert(Bits > 0 && Bits % BLOCK_WIDTH == 0,
+                "faint width must be a multiple of BLOCK_WIDTH");
+
+public:
+  /**
+   * Number of blocks of a faint.
+   */
+  static constexpr size_t BLOCKS = Bits / BLOCK_WIDTH;
+
+private:
+  /**
+   * Blocks of the faint, least significant first.
+   */
+  block_t blocks_[BLOCKS] = {};
+
+  /**
+   * @return The number of leading zero bits of a non-zero block
+   */
+  static constexpr unsigned count_leading_zeros(block_t u) noexcept;
+  /**
+   * Knuth's algorithm D on the fixed number of blocks.
+   * @throw std::invalid_argument Thrown if the divisor is zero
+   */
+  static constexpr void divmod(const faint &a, const faint &b, faint &q,
+                               faint &r);
+
+public:
+  constexpr faint() noexcept = default;
+  constexpr faint(block_t u) noexcept;
+  /**
+   * @param blocks The blocks, least significant first, the blocks above
+   * faint::BLOCKS being ignored
+   * @param n The number of blocks
+   */
+  constexpr faint(const block_t *blocks, size_t n) noexcept;
+  /**
+   * Keeps the Bits least significant bits of an aint.
+   */
+  explicit faint(const aint &a) noexcept;
+  explicit operator aint() const;
+
+  /**
+   * @return The blocks of the faint, faint::BLOCKS of them
+   */
+  constexpr const block_t *data() const noexcept;
+  /**
+   * @return The number of blocks representing the faint, excluding the
+   * trailing zero blocks as aint::size()
+   */
+  constexpr size_t size() const noexcept;
+  /**
+   * @return An aint view of the blocks, valid as long as the faint is not
+   * modified or destroyed
+   */
+  aint_view view() const noexcept;
+  /**
+   * @see aint::to_string(unsigned)
+   */
+  char *to_string(unsigned base = 2) const;
+
+  constexpr bool zero() const noexcept;
+  constexpr size_t bit_length() const noexcept;
+  constexpr size_t popcount() const noexcept;
+  constexpr bool test_bit(size_t index) const noexcept;
+  constexpr size_t count_trailing_zeros() const noexcept;
+
+  constexpr bool operator<(const faint &other) const noexcept;
+  constexpr bool operator>(const faint &other) const noexcept;
+  constexpr bool operator<=(const faint &other) const noexcept;
+  constexpr bool operator>=(const faint &other) const noexcept;
+  constexpr bool operator==(const faint &other) const noexcept;
+  constexpr bool operator!=(const faint &other) const noexcept;
+
+  constexpr faint &operator+=(const faint &other) noexcept;
+  constexpr faint &operator-=(const faint &other) noexcept;
+  constexpr faint &operator*=(const faint &other) noexcept;
+  /**
+   * @throw std::invalid_argument Thrown by `/=` and `%=` if the divisor is zero
+   */
+  constexpr faint &operator/=(const faint &other);
+  constexpr faint &operator%=(const faint &other);
+  constexpr faint &operator<<=(size_t offset) noexcept;
+  constexpr faint &operator>>=(size_t offset) noexcept;
+  constexpr faint &operator&=(const faint &other) noexcept;
+  constexpr faint &operator|=(const faint &other) noexcept;
+  constexpr faint &operator^=(const faint &other) noexcept;
+
+  constexpr faint operator+(const faint &other) const noexcept;
+  constexpr faint operator-(const faint &other) const noexcept;
+  constexpr faint operator*(const faint &other) const noexcept;
+  constexpr faint operator/(const faint &other) const;
+  constexpr faint operator%(const faint &other) const;
+  constexpr faint operator<<(size_t offset) const noexcept;
+  constexpr faint operator>>(size_t offset) const noexcept;
+  constexpr faint operator&(const faint &other) const noexcept;
+  constexpr faint operator|(const faint &other) const noexcept;
+  constexpr faint operator^(const faint &other) const noexcept;
+  /**
+   * @return The ones' complement of all the Bits bits of the faint
+   */
+  constexpr faint operator~() const noexcept;
+};
+
+template <size_t Bits>
+std::ostream &operator<<(std::ostream &o, const faint<Bits> &a) {
+  return o << a.view().value();
+}
+
+template <size_t Bits>
+constexpr unsigned faint<Bits>::count_leading_zeros(block_t u) noexcept {
+#if BLOCK_WIDTH == 64
+  return static_cast<unsigned>(__builtin_clzll(u));
+#else
+  return static_cast<unsigned>(__builtin_clz(u));
+#endif
+}
+
+template <size_t Bits>
+constexpr faint<Bits>::faint(block_t u) noexcept {
+  this->blocks_[0] = u;
+}
+
+template <size_t Bits>
+constexpr faint<Bits>::faint(const block_t *blocks, size_t n) noexcept {
+  for (size_t i = 0; i < BLOCKS && i < n; i++) {
+    this->blocks_[i] = blocks[i];
+  }
+}
+
+template <size_t Bits>
+faint<Bits>::faint(const aint &a) noexcept
+    : faint(a.blocks_, a.size()) {}
+
+template <size_t Bits> faint<Bits>::operator aint() const {
+  return aint(this->view().value());
+}
+
+template <size_t Bits>
+constexpr const block_t *faint<Bits>::data() const noexcept {
+  return this->blocks_;
+}
+
+template <size_t Bits> constexpr size_t faint<Bits>::size() const noexcept {
+  size_t n = BLOCKS;
+  for (; n > 0 && this->blocks_[n - 1] == 0; n--) {
+  }
+  return n;
+}
+
+template <size_t Bits> aint_view faint<Bits>::view() const noexcept {
+  return aint_view(this->blocks_, BLOCKS);
+}
+
+template <size_t Bits> char *faint<Bits>::to_string(unsigned base) const {
+  return this->view().value().to_string(base);
+}
+
+template <size_t Bits> constexpr bool faint<Bits>::zero() const noexcept {
+  return this->size() == 0;
+}
+
+template <size_t Bits>
+constexpr size_t faint<Bits>::bit_length() const noexcept {
+  size_t n = this->size();
+  if (n == 0) {
+    return 0;
+  }
+  return n * BLOCK_WIDTH - count_leading_zeros(this->blocks_[n - 1]);
+}
+
+template <size_t Bits>
+constexpr size_t faint<Bits>::popcount() const noexcept {
+  size_t count = 0;
+  for (size_t i = 0; i < BLOCKS; i++) {
+#if BLOCK_WIDTH == 64
+    count += static_cast<size_t>(__builtin_popcountll(this->blocks_[i]));
+#else
+    count += static_cast<size_t>(__builtin_popcount(this->blocks_[i]));
+#endif
+  }
+  return count;
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::test_bit(size_t index) const noexcept {
+  if (index >= Bits) {
+    return false;
+  }
+  return (this->blocks_[index / BLOCK_WIDTH] >> (index % BLOCK_WIDTH)) & 1;
+}
+
+template <size_t Bits>
+constexpr size_t faint<Bits>::count_trailing_zeros() const noexcept {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    if (this->blocks_[i] != 0) {
+#if BLOCK_WIDTH == 64
+      return i * BLOCK_WIDTH +
+             static_cast<size_t>(__builtin_ctzll(this->blocks_[i]));
+#else
+      return i * BLOCK_WIDTH +
+             static_cast<size_t>(__builtin_ctz(this->blocks_[i]));
+#endif
+    }
+  }
+  return 0;
+}
+
+/**
+ * Lower/greater-like operations are done using the most-significant block first
+ * on to the least.
+ */
+template <size_t Bits>
+constexpr bool faint<Bits>::operator<(const faint &other) const noexcept {
+  for (size_t i = BLOCKS; i > 0; i--) {
+    if (this->blocks_[i - 1] != other.blocks_[i - 1]) {
+      return this->blocks_[i - 1] < other.blocks_[i - 1];
+    }
+  }
+  return false;
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::operator>(const faint &other) const noexcept {
+  return other < *this;
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::operator<=(const faint &other) const noexcept {
+  return !(other < *this);
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::operator>=(const faint &other) const noexcept {
+  return !(*this < other);
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::operator==(const faint &other) const noexcept {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    if (this->blocks_[i] != other.blocks_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <size_t Bits>
+constexpr bool faint<Bits>::operator!=(const faint &other) const noexcept {
+  return !(*this == other);
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator+=(const faint &other) noexcept {
+  block_t carry = 0;
+  for (size_t i = 0; i < BLOCKS; i++) {
+    dblock_t sum = static_cast<dblock_t>(this->blocks_[i]) +
+                   other.blocks_[i] + carry;
+    this->blocks_[i] = static_cast<block_t>(sum);
+    carry = static_cast<block_t>(sum >> BLOCK_WIDTH);
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator-=(const faint &other) noexcept {
+  block_t borrow = 0;
+  for (size_t i = 0; i < BLOCKS; i++) {
+    block_t a = this->blocks_[i], b = other.blocks_[i];
+    this->blocks_[i] = a - b - borrow;
+    borrow = a < b || (a == b && borrow != 0);
+  }
+  return *this;
+}
+
+/**
+ * Schoolbook multiplication, only the products landing in the Bits least
+ * significant bits being computed.
+ */
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator*=(const faint &other) noexcept {
+  faint res;
+  for (size_t i = 0; i < BLOCKS; i++) {
+    block_t carry = 0;
+    for (size_t j = 0; i + j < BLOCKS; j++) {
+      dblock_t product =
+          static_cast<dblock_t>(this->blocks_[i]) * other.blocks_[j] +
+          res.blocks_[i + j] + carry;
+      res.blocks_[i + j] = static_cast<block_t>(product);
+      carry = static_cast<block_t>(product >> BLOCK_WIDTH);
+    }
+  }
+  *this = res;
+  return *this;
+}
+
+template <size_t Bits>
+constexpr void faint<Bits>::divmod(const faint &a, const faint &b, faint &q,
+                                   faint &r) {
+  size_t an = a.size(), dn = b.size();
+  if (dn == 0) {
+    throw std::invalid_argument("division by zero");
+  }
+  faint quotient;
+  if (a < b) {
+    r = a;
+    q = quotient;
+    return;
+  }
+  if (dn == 1) {
+    dblock_t rest = 0;
+    for (size_t i = an; i > 0; i--) {
+      dblock_t current = (rest << BLOCK_WIDTH) | a.blocks_[i - 1];
+      quotient.blocks_[i - 1] = static_cast<block_t>(current / b.blocks_[0]);
+      rest = current % b.blocks_[0];
+    }
+    q = quotient;
+    r = faint(static_cast<block_t>(rest));
+    return;
+  }
+
+  // Both operands are shifted so that the most significant bit of the
+  // divisor is set.
+  unsigned shift = count_leading_zeros(b.blocks_[dn - 1]);
+  block_t u[BLOCKS + 1] = {}, v[BLOCKS] = {};
+  for (size_t i = 0; i < an; i++) {
+    u[i] |= a.blocks_[i] << shift;
+    if (shift != 0) {
+      u[i + 1] = a.blocks_[i] >> (BLOCK_WIDTH - shift);
+    }
+  }
+  for (size_t i = 0; i < dn; i++) {
+    v[i] |= b.blocks_[i] << shift;
+    if (shift != 0 && i + 1 < dn) {
+      v[i + 1] = b.blocks_[i] >> (BLOCK_WIDTH - shift);
+    }
+  }
+
+  const block_t v_high = v[dn - 1], v_next = v[dn - 2];
+  for (size_t j = an - dn + 1; j > 0; j--) {
+    block_t *window = u + j - 1;
+    // Estimates the quotient block from the two most significant blocks.
+    dblock_t numerator =
+        (static_cast<dblock_t>(window[dn]) << BLOCK_WIDTH) | window[dn - 1];
+    dblock_t q_estimate = numerator / v_high;
+    dblock_t r_estimate = numerator % v_high;
+    while (q_estimate > BLOCK_MAX ||
+           q_estimate * v_next >
+               ((r_estimate << BLOCK_WIDTH) | window[dn - 2])) {
+      q_estimate--;
+      r_estimate += v_high;
+      if (r_estimate > BLOCK_MAX) {
+        break;
+      }
+    }
+    // Multiplies and subtracts, adding back once if the estimate was too high.
+    block_t borrow = 0;
+    for (size_t i = 0; i < dn; i++) {
+      dblock_t product = q_estimate * v[i] + borrow;
+      block_t low = static_cast<block_t>(product);
+      borrow = static_cast<block_t>(product >> BLOCK_WIDTH) + (window[i] < low);
+      window[i] -= low;
+    }
+    block_t top = window[dn];
+    window[dn] = top - borrow;
+    if (top < borrow) {
+      q_estimate--;
+      block_t carry = 0;
+      for (size_t i = 0; i < dn; i++) {
+        dblock_t sum = static_cast<dblock_t>(window[i]) + v[i] + carry;
+        window[i] = static_cast<block_t>(sum);
+        carry = static_cast<block_t>(sum >> BLOCK_WIDTH);
+      }
+      window[dn] += carry;
+    }
+    quotient.blocks_[j - 1] = static_cast<block_t>(q_estimate);
+  }
+
+  faint rest;
+  for (size_t i = 0; i < dn; i++) {
+    rest.blocks_[i] = u[i] >> shift;
+    if (shift != 0) {
+      rest.blocks_[i] |= u[i + 1] << (BLOCK_WIDTH - shift);
+    }
+  }
+  q = quotient;
+  r = rest;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator/=(const faint &other) {
+  faint rest;
+  divmod(*this, other, *this, rest);
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator%=(const faint &other) {
+  faint quotient;
+  divmod(*this, other, quotient, *this);
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator<<=(size_t offset) noexcept {
+  if (offset >= Bits) {
+    *this = faint();
+    return *this;
+  }
+  size_t block_offset = offset / BLOCK_WIDTH;
+  unsigned bit_offset = offset % BLOCK_WIDTH;
+  for (size_t i = BLOCKS; i > block_offset; i--) {
+    block_t block = this->blocks_[i - 1 - block_offset] << bit_offset;
+    if (bit_offset != 0 && i - 1 > block_offset) {
+      block |= this->blocks_[i - 2 - block_offset] >> (BLOCK_WIDTH - bit_offset);
+    }
+    this->blocks_[i - 1] = block;
+  }
+  for (size_t i = 0; i < block_offset; i++) {
+    this->blocks_[i] = 0;
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator>>=(size_t offset) noexcept {
+  if (offset >= Bits) {
+    *this = faint();
+    return *this;
+  }
+  size_t block_offset = offset / BLOCK_WIDTH;
+  unsigned bit_offset = offset % BLOCK_WIDTH;
+  for (size_t i = 0; i + block_offset < BLOCKS; i++) {
+    block_t block = this->blocks_[i + block_offset] >> bit_offset;
+    if (bit_offset != 0 && i + block_offset + 1 < BLOCKS) {
+      block |= this->blocks_[i + block_offset + 1]
+               << (BLOCK_WIDTH - bit_offset);
+    }
+    this->blocks_[i] = block;
+  }
+  for (size_t i = BLOCKS - block_offset; i < BLOCKS; i++) {
+    this->blocks_[i] = 0;
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator&=(const faint &other) noexcept {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    this->blocks_[i] &= other.blocks_[i];
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator|=(const faint &other) noexcept {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    this->blocks_[i] |= other.blocks_[i];
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> &faint<Bits>::operator^=(const faint &other) noexcept {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    this->blocks_[i] ^= other.blocks_[i];
+  }
+  return *this;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator+(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res += other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator-(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res -= other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator*(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res *= other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator/(const faint &other) const {
+  faint quotient, rest;
+  divmod(*this, other, quotient, rest);
+  return quotient;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator%(const faint &other) const {
+  faint quotient, rest;
+  divmod(*this, other, quotient, rest);
+  return rest;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator<<(size_t offset) const noexcept {
+  faint res = *this;
+  res <<= offset;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator>>(size_t offset) const noexcept {
+  faint res = *this;
+  res >>= offset;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator&(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res &= other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator|(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res |= other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator^(const faint &other) const
+    noexcept {
+  faint res = *this;
+  res ^= other;
+  return res;
+}
+
+template <size_t Bits>
+constexpr faint<Bits> faint<Bits>::operator~() const noexcept {
+  faint res;
+  for (size_t i = 0; i < BLOCKS; i++) {
+    res.blocks_[i] = ~this->blocks_[i];
+  }
+  return res;
+}
+
+#endif // LAB_AINT_FAINT_H_
@@ -0,0 +1,226 @@
+#include "aint.hpp"
+#include "mpn.hpp"
+#include <algorithm>
+#include <utility>
+
+/**
+ * @return The number of trailing zero bits of a non-zero double-block
+ */
+static unsigned trailing_zeros(dblock_t u) {
+  unsigned count = 0;
+  for (; static_cast<block_t>(u) == 0; u >>= BLOCK_WIDTH) {
+    count += BLOCK_WIDTH;
+  }
+  block_t low = static_cast<block_t>(u);
+#if BLOCK_WIDTH == 64
+  return count + static_cast<unsigned>(__builtin_ctzll(low));
+#else
+  return count + static_cast<unsigned>(__builtin_ctz(low));
+#endif
+}
+
+/**
+ * Binary GCD, used once both operands fit in a double-block.
+ */
+static dblock_t binary_gcd(dblock_t u, dblock_t v) {
+  if (u == 0 || v == 0) {
+    return u | v;
+  }
+  unsigned shift = trailing_zeros(u | v);
+  u >>= trailing_zeros(u);
+  do {
+    v >>= trailing_zeros(v);
+    if (u > v) {
+      std::swap(u, v);
+    }
+    v -= u;
+  } while (v != 0);
+  return u << shift;
+}
+
+aint aint::euclid(aint u, aint v, aint *cofactor) {
+  // The cofactors of the first operand are kept as magnitudes, the signed
+  // cofactors of u and v being of opposite signs: u = +-su * a (mod b) and
+  // v = -+sv * a (mod b), `negative` giving the sign of su.
+  const aint modulus = v;
+  bool tracked = cofactor != nullptr;
+  aint su = 1u, sv = 0u;
+  bool negative = false;
+  if (u < v) {
+    u.swap(v);
+    su.swap(sv);
+    negative = true;
+  }
+  auto to_dblock = [](const aint &a) {
+    dblock_t value = a.size() > 0 ? a.blocks_[0] : 0;
+    if (a.size() > 1) {
+      value |= static_cast<dblock_t>(a.blocks_[1]) << BLOCK_WIDTH;
+    }
+    return value;
+  };
+  // Bits [from, from + 2 * BLOCK_WIDTH - 2) of an aint lower than
+  // 2^(from + 2 * BLOCK_WIDTH - 2).
+  auto leading_bits = [](const aint &a, size_t from) {
+    size_t index = from / BLOCK_WIDTH;
+    unsigned shift = from % BLOCK_WIDTH;
+    dblock_t value = a.blocks_[index] >> shift;
+    if (index + 1 < a.size()) {
+      value |= static_cast<dblock_t>(a.blocks_[index + 1]) << (BLOCK_WIDTH -
+                                                               shift);
+    }
+    if (shift != 0 && index + 2 < a.size()) {
+      value |= static_cast<dblock_t>(a.blocks_[index + 2])
+               << (2 * BLOCK_WIDTH - shift);
+    }
+    return value;
+  };
+  // r = p * x - m * y, on n blocks, for a result known to be lower than x.
+  auto combine = [](aint &r, block_t p, const aint &x, block_t m,
+                    const aint &y, size_t n) {
+    r.reserve(n);
+    std::fill(r.blocks_ + std::min(n, r.size()), r.blocks_ + r.size(), 0);
+    mpn::mul_1(r.blocks_, x.blocks_, n, p);
+    mpn::submul_1(r.blocks_, y.blocks_, n, m);
+    r.size_ = n;
+    r.refresh_size();
+  };
+
+  aint q, r;
+  while (!v.zero()) {
+    if (!tracked && v.size() <= 2) {
+      if (u.size() > 2) {
+        divmod(u, v, q, r);
+        u.swap(v);
+        v.swap(r);
+      }
+      return aint::from_dblock(binary_gcd(to_dblock(u), to_dblock(v)));
+    }
+
+    // Knuth's algorithm L on the 2 * BLOCK_WIDTH - 2 leading bits, the
+    // quotients being accepted while both bounds of the approximations agree
+    // and the cofactors fit in a block. The cofactor matrix is
+    // [[a, -b], [-c, d]] after an even number of steps, [[-a, b], [c, -d]]
+    // after an odd one.
+    size_t n = u.size();
+    block_t ca = 1, cb = 0, cc = 0, cd = 1;
+    bool odd = false;
+    if (n >= 2 && v.size() == n) {
+      size_t bits = u.bit_length();
+      size_t from = bits > 2 * BLOCK_WIDTH - 2 ? bits - (2 * BLOCK_WIDTH - 2)
+                                               : 0;
+      dblock_t uh = leading_bits(u, from), vh = leading_bits(v, from);
+      while (true) {
+        dblock_t low_num, low_den, high_num, high_den;
+        if (!odd) {
+          if (vh <= cc || uh < cb) {
+            break;
+          }
+          low_num = uh + ca;
+          low_den = vh - cc;
+          high_num = uh - cb;
+          high_den = vh + cd;
+        } else {
+          if (vh <= cd || uh < ca) {
+            break;
+          }
+          low_num = uh - ca;
+          low_den = vh + cc;
+          high_num = uh + cb;
+          high_den = vh - cd;
+        }
+        dblock_t quotient = low_num / low_den;
+        if (quotient != high_num / high_den || quotient > BLOCK_MAX ||
+            quotient > uh / vh) {
+          break;
+        }
+        dblock_t next_c = ca + quotient * cc, next_d = cb + quotient * cd;
+        if (next_c > BLOCK_MAX || next_d > BLOCK_MAX) {
+          break;
+        }
+        ca = cc;
+        cb = cd;
+        cc = static_cast<block_t>(next_c);
+        cd = static_cast<block_t>(next_d);
+        dblock_t rest = uh - quotient * vh;
+        uh = vh;
+        vh = rest;
+        odd = !odd;
+      }
+    }
+
+    if (cb == 0) {
+      // No quotient could be guessed, a full division step is taken instead.
+      divmod(u, v, q, r);
+      u.swap(v);
+      v.swap(r);
+      if (tracked) {
+        addmul(su, q, sv);
+        su.swap(sv);
+        negative = !negative;
+      }
+      continue;
+    }
+    if (!odd) {
+      combine(q, ca, u, cb, v, n);
+      combine(r, cd, v, cc, u, n);
+    } else {
+      combine(q, cb, v, ca, u, n);
+      combine(r, cc, u, cd, v, n);
+    }
+    u.swap(q);
+    v.swap(r);
+    if (tracked) {
+      // The signs alternate along the matrix, the magnitudes add up.
+      aint next_su = su, next_sv = su;
+      next_su *= ca;
+      next_sv *= cc;
+      addmul(next_su, sv, aint(cb));
+      addmul(next_sv, sv, aint(cd));
+      su.swap(next_su);
+      sv.swap(next_sv);
+      negative = negative != odd;
+    }
+  }
+
+  if (tracked) {
+    aint order = modulus / u;
+    *cofactor = su % order;
+    if (negative && !cofactor->zero()) {
+      *cofactor = order - *cofactor;
+    }
+    if (cofactor->zero()) {
+      *cofactor = order;
+    }
+  }
+  return u;
+}
+
+aint gcd(const aint &a, const aint &b) { return aint::euclid(a, b, nullptr); }
+
+aint xgcd(const aint &a, const aint &b, aint &s, aint &t) {
+  if (a.zero()) {
+    throw std::invalid_argument("a");
+  }
+  if (b.zero()) {
+    s = 1u;
+    t = 0u;
+    return a;
+  }
+  aint g = aint::euclid(a, b, &s);
+  t = (a * s - g) / b;
+  return g;
+}
+
+aint modinv(const aint &a, const aint &m) {
+  if (m.zero()) {
+    throw std::invalid_argument("m");
+  }
+  if (m == aint(1u)) {
+    return aint();
+  }
+  aint x, residue = a % m;
+  if (residue.zero() || aint::euclid(residue, m, &x) != aint(1u)) {
+    throw std::invalid_argument("a");
+  }
+  return x;
+}
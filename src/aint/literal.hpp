@@ -0,0 +1,127 @@
+#ifndef LAB_AINT_LITERAL_H_
+#define LAB_AINT_LITERAL_H_
+#include "aint.hpp"
+#include "view.hpp"
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * The `_ai` literals, made available with `using namespace aint_literals;`.
+ */
+namespace aint_literals {
+
+namespace detail {
+
+/**
+ * @return The base of an integer literal from its prefix: 16 for `0x`, 2 for
+ * `0b`, 8 for a leading zero and 10 otherwise
+ */
+constexpr unsigned literal_base(const char *digits, size_t n) {
+  if (n >= 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+    return 16;
+  }
+  if (n >= 2 && digits[0] == '0' && (digits[1] == 'b' || digits[1] == 'B')) {
+    return 2;
+  }
+  if (n >= 2 && digits[0] == '0') {
+    return 8;
+  }
+  return 10;
+}
+
+constexpr size_t prefix_length(unsigned base) {
+  return base == 16 || base == 2 ? 2 : base == 8 ? 1 : 0;
+}
+
+/**
+ * @return An upper bound of the number of blocks of a literal
+ */
+constexpr size_t literal_blocks(const char *digits, size_t n) {
+  unsigned base = literal_base(digits, n);
+  size_t count = n - prefix_length(base);
+  size_t bits = base == 10   ? count * 10 / 3 + 1
+                : base == 16 ? count * 4
+                : base == 8  ? count * 3
+                             : count;
+  return bits / BLOCK_WIDTH + 1;
+}
+
+/**
+ * @return The value of a digit, 16 if the character is not a digit
+ */
+constexpr unsigned digit_value(char c) {
+  return c >= '0' && c <= '9'   ? static_cast<unsigned>(c - '0')
+         : c >= 'a' && c <= 'f' ? static_cast<unsigned>(c - 'a' + 10)
+         : c >= 'A' && c <= 'F' ? static_cast<unsigned>(c - 'A' + 10)
+                                : 16;
+}
+
+/**
+ * Blocks of a parsed literal, least significant first.
+ */
+template <size_t N> struct literal_t {
+  block_t blocks[N] = {};
+  /**
+   * Number of blocks of the value, excluding the trailing zero blocks.
+   */
+  size_t size = 0;
+};
+
+/**
+ * Parses the characters of an integer literal, digit separators included, by
+ * multiplying the blocks parsed so far by the base for each digit.
+ * @throw std::invalid_argument Thrown, making the literal ill-formed, if a
+ * digit is not valid in the base of the literal
+ */
+template <size_t N>
+constexpr literal_t<N> parse_literal(const char *digits, size_t n) {
+  literal_t<N> literal;
+  unsigned base = literal_base(digits, n);
+  for (size_t i = prefix_length(base); i < n; i++) {
+    if (digits[i] == '\'') {
+      continue;
+    }
+    unsigned digit = digit_value(digits[i]);
+    if (digit >= base) {
+      throw std::invalid_argument("Invalid digit in aint literal");
+    }
+    block_t carry = digit;
+    for (size_t j = 0; j < literal.size; j++) {
+      dblock_t value = static_cast<dblock_t>(literal.blocks[j]) * base + carry;
+      literal.blocks[j] = static_cast<block_t>(value);
+      carry = static_cast<block_t>(value >> BLOCK_WIDTH);
+    }
+    if (carry != 0) {
+      literal.blocks[literal.size++] = carry;
+    }
+  }
+  return literal;
+}
+
+/**
+ * Static storage of the blocks of a literal, parsed at compile time.
+ */
+template <char... Digits> struct literal_storage {
+  static constexpr char digits[] = {Digits...};
+  static constexpr literal_t<literal_blocks(digits, sizeof...(Digits))> value =
+      parse_literal<literal_blocks(digits, sizeof...(Digits))>(
+          digits, sizeof...(Digits));
+};
+
+} // namespace detail
+
+/**
+ * Integer literal of any length, in base 2 (`0b`), 8 (leading `0`), 10 or 16
+ * (`0x`) as the built-in integer literals, such as `0xffffffffffffffffff_ai`.
+ * The blocks are computed at compile time and stored in static storage.
+ * @return A view of the blocks, used as an operand without copying any block,
+ * or copied into an aint
+ */
+template <char... Digits> aint_view operator""_ai() {
+  using storage = detail::literal_storage<Digits...>;
+  return aint_view(storage::value.blocks, storage::value.size);
+}
+
+} // namespace aint_literals
+
+#endif // LAB_AINT_LITERAL_H_
@@ -0,0 +1,147 @@
+#include "montgomery.hpp"
+#include "mpn.hpp"
+#include <algorithm>
+#include <exception>
+
+montgomery_ctx::montgomery_ctx(const aint &modulus) : modulus_(modulus) {
+  if (modulus.zero() || modulus.blocks_[0] % 2 == 0) {
+    throw std::invalid_argument("modulus");
+  }
+  size_t n = modulus.size();
+  // An odd number is its own inverse modulo 8, each Newton iteration
+  // x = x * (2 - N * x) then doubles the number of correct bits.
+  block_t n0 = modulus.blocks_[0], inverse = n0;
+  for (int i = 0; i < 5; i++) {
+    inverse *= static_cast<block_t>(2 - n0 * inverse);
+  }
+  this->inverse_ = static_cast<block_t>(0 - inverse);
+  this->product_.resize(2 * n + 1);
+  this->scratch_.resize(mpn::mul_itch(n));
+  aint one = 1u;
+  this->one_ = (one << (BLOCK_WIDTH * n)) % modulus;
+  this->r2_ = (one << (2 * BLOCK_WIDTH * n)) % modulus;
+}
+
+const aint &montgomery_ctx::modulus() const noexcept { return this->modulus_; }
+
+size_t montgomery_ctx::size() const noexcept { return this->modulus_.size(); }
+
+/**
+ * Each pass adds the multiple of N cancelling the lowest block, the product
+ * being divided by R once all the `n` low blocks are zero. The result is then
+ * lower than 2 * N.
+ */
+void montgomery_ctx::redc(aint &r) {
+  size_t n = this->size();
+  block_t *t = this->product_.data();
+  const block_t *m = this->modulus_.blocks_;
+  for (size_t i = 0; i < n; i++) {
+    block_t q = static_cast<block_t>(t[i] * this->inverse_);
+    block_t carry = mpn::addmul_1(t + i, m, n, q);
+    mpn::add_1(t + i + n, t + i + n, n + 1 - i, carry);
+  }
+  block_t *result = t + n;
+  if (result[n] != 0 || mpn::cmp(result, m, n) >= 0) {
+    mpn::sub_n(result, result, m, n);
+  }
+  r.reserve(n);
+  if (r.size() > n) {
+    std::fill(r.blocks_ + n, r.blocks_ + r.size(), 0);
+  }
+  std::copy(result, result + n, r.blocks_);
+  r.size_ = n;
+  r.refresh_size();
+}
+
+aint montgomery_ctx::to_montgomery(const aint &a) {
+  aint r;
+  if (a < this->modulus_) {
+    this->mulmod(r, a, this->r2_);
+  } else {
+    this->mulmod(r, a % this->modulus_, this->r2_);
+  }
+  return r;
+}
+
+aint montgomery_ctx::from_montgomery(const aint &a) {
+  std::fill(this->product_.begin(), this->product_.end(), 0);
+  std::copy(a.blocks_, a.blocks_ + a.size(), this->product_.begin());
+  aint r;
+  this->redc(r);
+  return r;
+}
+
+void montgomery_ctx::mulmod(aint &r, const aint &a, const aint &b) {
+  std::fill(this->product_.begin(), this->product_.end(), 0);
+  if (!a.zero() && !b.zero()) {
+    const aint *x = &a, *y = &b;
+    if (x->size() < y->size()) {
+      std::swap(x, y);
+    }
+    mpn::mul(this->product_.data(), x->blocks_, x->size(), y->blocks_,
+             y->size(), this->scratch_.data());
+  }
+  this->redc(r);
+}
+
+void montgomery_ctx::sqrmod(aint &r, const aint &a) {
+  std::fill(this->product_.begin(), this->product_.end(), 0);
+  if (!a.zero()) {
+    mpn::sqr(this->product_.data(), a.blocks_, a.size(),
+             this->scratch_.data());
+  }
+  this->redc(r);
+}
+
+/**
+ * The exponent is scanned from its most significant bit. Each window of at
+ * most `window` bits starting and ending with a set bit costs one product by a
+ * precomputed odd power of the base.
+ */
+aint montgomery_ctx::powmod(const aint &base, const aint &exponent) {
+  size_t n = this->size();
+  size_t bits = exponent.bit_length();
+  size_t window = bits > 671   ? 6
+                  : bits > 239 ? 5
+                  : bits > 79  ? 4
+                  : bits > 23  ? 3
+                               : 1;
+
+  // powers[i] = base^(2i + 1)
+  std::vector<aint> powers(static_cast<size_t>(1) << (window - 1));
+  powers[0] = this->to_montgomery(base);
+  powers[0].reserve(n);
+  if (window > 1) {
+    aint square;
+    this->sqrmod(square, powers[0]);
+    for (size_t i = 1; i < powers.size(); i++) {
+      powers[i].reserve(n);
+      this->mulmod(powers[i], powers[i - 1], square);
+    }
+  }
+
+  aint result = this->one_;
+  result.reserve(n);
+  for (size_t i = bits; i > 0;) {
+    if (!exponent.test_bit(i - 1)) {
+      this->sqrmod(result, result);
+      i--;
+      continue;
+    }
+    // The window covers the bits [j, i), bit j being set.
+    size_t j = i > window ? i - window : 0;
+    while (!exponent.test_bit(j)) {
+      j++;
+    }
+    size_t value = 0;
+    for (size_t k = i; k > j; k--) {
+      value = (value << 1) | (exponent.test_bit(k - 1) ? 1 : 0);
+    }
+    for (size_t k = j; k < i; k++) {
+      this->sqrmod(result, result);
+    }
+    this->mulmod(result, result, powers[value >> 1]);
+    i = j;
+  }
+  return this->from_montgomery(result);
+}
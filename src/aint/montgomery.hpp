@@ -0,0 +1,91 @@
+#ifndef LAB_AINT_MONTGOMERY_H_
+#define LAB_AINT_MONTGOMERY_H_
+#include "aint.hpp"
+#include <vector>
+
+/**
+ * Modular arithmetic modulo an odd number N of `n` blocks in Montgomery form,
+ * where a value x is represented by x * R mod N with R = 2^(BLOCK_WIDTH * n).
+ *
+ * @details
+ * A product of two values in Montgomery form is reduced with Montgomery's
+ * REDC, which replaces the division by N with `n` multiply-and-add passes
+ * using -N^-1 mod 2^BLOCK_WIDTH.
+ *
+ * @note
+ * The context keeps its scratch storage between operations: results
+ * preallocated with `n` blocks are computed without any allocation. A context
+ * must therefore not be shared between threads.
+ */
+class montgomery_ctx {
+  aint modulus_;
+  /**
+   * -N^-1 mod 2^BLOCK_WIDTH.
+   */
+  block_t inverse_;
+  /**
+   * R^2 mod N, converting values to the Montgomery form.
+   */
+  aint r2_;
+  /**
+   * R mod N, the Montgomery form of 1.
+   */
+  aint one_;
+  /**
+   * Storage of the unreduced products, then of the multiplication scratch.
+   */
+  std::vector<block_t> product_, scratch_;
+
+  /**
+   * Reduces the product stored in montgomery_ctx::product_ into `r`.
+   */
+  void redc(aint &r);
+
+public:
+  /**
+   * @param modulus The odd modulus
+   * @throw std::invalid_argument Thrown if the modulus is even
+   */
+  explicit montgomery_ctx(const aint &modulus);
+
+  /**
+   * @return The modulus of the context
+   */
+  const aint &modulus() const noexcept;
+  /**
+   * @return The number of blocks of the values in Montgomery form
+   */
+  size_t size() const noexcept;
+
+  /**
+   * @return The Montgomery form of a % N
+   */
+  aint to_montgomery(const aint &a);
+  /**
+   * @return The value represented by `a`, in Montgomery form
+   */
+  aint from_montgomery(const aint &a);
+
+  /**
+   * Computes r = a * b * R^-1 mod N, the Montgomery form of the product of the
+   * values represented by `a` and `b`.
+   * @param r The result, which may alias the operands
+   * @param a An operand in Montgomery form, lower than N
+   * @param b An operand in Montgomery form, lower than N
+   */
+  void mulmod(aint &r, const aint &a, const aint &b);
+  /**
+   * Computes r = a * a * R^-1 mod N.
+   * @see montgomery_ctx::mulmod(aint &, const aint &, const aint &)
+   */
+  void sqrmod(aint &r, const aint &a);
+  /**
+   * Computes base^exponent mod N with sliding-window exponentiation.
+   * @param base The base, not in Montgomery form
+   * @param exponent The exponent
+   * @return The result, not in Montgomery form
+   */
+  aint powmod(const aint &base, const aint &exponent);
+};
+
+#endif // LAB_AINT_MONTGOMERY_H_
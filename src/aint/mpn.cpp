@@ -0,0 +1,266 @@
+#include "mpn.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define AINT_HAVE_ADDCARRY 1
+#else
+#define AINT_HAVE_ADDCARRY 0
+#endif
+
+namespace mpn {
+
+size_t normalized_size(const block_t *a, size_t n) {
+  for (; n > 0 && a[n - 1] == 0; n--) {
+  }
+  return n;
+}
+
+int cmp(const block_t *a, const block_t *b, size_t n) {
+  for (size_t i = n; i > 0; i--) {
+    if (a[i - 1] != b[i - 1]) {
+      return a[i - 1] < b[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Adds two blocks and an incoming carry (0 or 1).
+ * @return The outgoing carry
+ */
+static inline unsigned char add_carry(unsigned char carry, block_t a,
+                                      block_t b, block_t *r) {
+#if AINT_HAVE_ADDCARRY && BLOCK_WIDTH == 64
+  unsigned long long sum;
+  carry = _addcarry_u64(carry, a, b, &sum);
+  *r = sum;
+  return carry;
+#elif AINT_HAVE_ADDCARRY && BLOCK_WIDTH == 32
+  unsigned int sum;
+  carry = _addcarry_u32(carry, a, b, &sum);
+  *r = sum;
+  return carry;
+#else
+  dblock_t sum = static_cast<dblock_t>(a) + b + carry;
+  *r = static_cast<block_t>(sum);
+  return static_cast<unsigned char>(sum >> BLOCK_WIDTH);
+#endif
+}
+
+/**
+ * Subtracts a block and an incoming borrow (0 or 1) from a block.
+ * @return The outgoing borrow
+ */
+static inline unsigned char sub_borrow(unsigned char borrow, block_t a,
+                                       block_t b, block_t *r) {
+#if AINT_HAVE_ADDCARRY && BLOCK_WIDTH == 64
+  unsigned long long diff;
+  borrow = _subborrow_u64(borrow, a, b, &diff);
+  *r = diff;
+  return borrow;
+#elif AINT_HAVE_ADDCARRY && BLOCK_WIDTH == 32
+  unsigned int diff;
+  borrow = _subborrow_u32(borrow, a, b, &diff);
+  *r = diff;
+  return borrow;
+#else
+  dblock_t diff = static_cast<dblock_t>(a) - b - borrow;
+  *r = static_cast<block_t>(diff);
+  return static_cast<unsigned char>(diff >> BLOCK_WIDTH) & 1;
+#endif
+}
+
+/**
+ * The carry is kept in a single chain, the loop being unrolled four times so
+ * that the compiler can keep it in the carry flag.
+ */
+block_t add_n(block_t *r, const block_t *a, const block_t *b, size_t n) {
+  unsigned char carry = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    carry = add_carry(carry, a[i], b[i], r + i);
+    carry = add_carry(carry, a[i + 1], b[i + 1], r + i + 1);
+    carry = add_carry(carry, a[i + 2], b[i + 2], r + i + 2);
+    carry = add_carry(carry, a[i + 3], b[i + 3], r + i + 3);
+  }
+  for (; i < n; i++) {
+    carry = add_carry(carry, a[i], b[i], r + i);
+  }
+  return carry;
+}
+
+block_t add(block_t *r, const block_t *a, size_t an, const block_t *b,
+            size_t bn) {
+  block_t carry = add_n(r, a, b, bn);
+  return add_1(r + bn, a + bn, an - bn, carry);
+}
+
+block_t add_1(block_t *r, const block_t *a, size_t n, block_t u) {
+  size_t i = 0;
+  for (; i < n && u != 0; i++) {
+    r[i] = a[i] + u;
+    u = r[i] < u;
+  }
+  // The carry has been absorbed, the remaining blocks are only copied.
+  if (r != a) {
+    for (; i < n; i++) {
+      r[i] = a[i];
+    }
+  }
+  return u;
+}
+
+block_t sub_n(block_t *r, const block_t *a, const block_t *b, size_t n) {
+  unsigned char borrow = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    borrow = sub_borrow(borrow, a[i], b[i], r + i);
+    borrow = sub_borrow(borrow, a[i + 1], b[i + 1], r + i + 1);
+    borrow = sub_borrow(borrow, a[i + 2], b[i + 2], r + i + 2);
+    borrow = sub_borrow(borrow, a[i + 3], b[i + 3], r + i + 3);
+  }
+  for (; i < n; i++) {
+    borrow = sub_borrow(borrow, a[i], b[i], r + i);
+  }
+  return borrow;
+}
+
+block_t sub(block_t *r, const block_t *a, size_t an, const block_t *b,
+            size_t bn) {
+  block_t borrow = sub_n(r, a, b, bn);
+  return sub_1(r + bn, a + bn, an - bn, borrow);
+}
+
+block_t sub_1(block_t *r, const block_t *a, size_t n, block_t u) {
+  size_t i = 0;
+  for (; i < n && u != 0; i++) {
+    block_t block = a[i];
+    r[i] = block - u;
+    u = block < u;
+  }
+  // The borrow has been absorbed, the remaining blocks are only copied.
+  if (r != a) {
+    for (; i < n; i++) {
+      r[i] = a[i];
+    }
+  }
+  return u;
+}
+
+block_t mul_1(block_t *r, const block_t *a, size_t n, block_t u) {
+  block_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    dblock_t product = static_cast<dblock_t>(a[i]) * u + carry;
+    r[i] = static_cast<block_t>(product);
+    carry = static_cast<block_t>(product >> BLOCK_WIDTH);
+  }
+  return carry;
+}
+
+block_t addmul_1(block_t *r, const block_t *a, size_t n, block_t u) {
+  block_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    // Cannot overflow: (2^w - 1)^2 + 2 * (2^w - 1) = 2^2w - 1.
+    dblock_t product = static_cast<dblock_t>(a[i]) * u + r[i] + carry;
+    r[i] = static_cast<block_t>(product);
+    carry = static_cast<block_t>(product >> BLOCK_WIDTH);
+  }
+  return carry;
+}
+
+block_t submul_1(block_t *r, const block_t *a, size_t n, block_t u) {
+  block_t borrow = 0;
+  for (size_t i = 0; i < n; i++) {
+    dblock_t product = static_cast<dblock_t>(a[i]) * u + borrow;
+    block_t low = static_cast<block_t>(product);
+    borrow = static_cast<block_t>(product >> BLOCK_WIDTH) + (r[i] < low);
+    r[i] -= low;
+  }
+  return borrow;
+}
+
+block_t lshift(block_t *r, const block_t *a, size_t n, unsigned count) {
+  if (n == 0) {
+    return 0;
+  }
+  block_t out = a[n - 1] >> (BLOCK_WIDTH - count);
+  for (size_t i = n - 1; i > 0; i--) {
+    r[i] = (a[i] << count) | (a[i - 1] >> (BLOCK_WIDTH - count));
+  }
+  r[0] = a[0] << count;
+  return out;
+}
+
+block_t rshift(block_t *r, const block_t *a, size_t n, unsigned count) {
+  if (n == 0) {
+    return 0;
+  }
+  block_t out = a[0] << (BLOCK_WIDTH - count);
+  for (size_t i = 0; i + 1 < n; i++) {
+    r[i] = (a[i] >> count) | (a[i + 1] << (BLOCK_WIDTH - count));
+  }
+  r[n - 1] = a[n - 1] >> count;
+  return out;
+}
+
+/**
+ * Vector of 128 bits of blocks, whose operations are lowered by the compiler
+ * to SSE2 or NEON instructions when they are available.
+ */
+typedef block_t block_vector_t __attribute__((vector_size(16)));
+static const size_t VECTOR_BLOCKS = sizeof(block_vector_t) / sizeof(block_t);
+
+/**
+ * Applies a bitwise operation, a vector of blocks at a time.
+ * @param operation Generic operation on two vectors or two blocks
+ */
+template <typename Operation>
+static inline void bitwise_n(block_t *r, const block_t *a, const block_t *b,
+                             size_t n, Operation operation) {
+  size_t i = 0;
+  for (; i + VECTOR_BLOCKS <= n; i += VECTOR_BLOCKS) {
+    block_vector_t x, y;
+    std::memcpy(&x, a + i, sizeof(x));
+    std::memcpy(&y, b + i, sizeof(y));
+    x = operation(x, y);
+    std::memcpy(r + i, &x, sizeof(x));
+  }
+  for (; i < n; i++) {
+    r[i] = operation(a[i], b[i]);
+  }
+}
+
+void and_n(block_t *r, const block_t *a, const block_t *b, size_t n) {
+  bitwise_n(r, a, b, n, [](auto x, auto y) { return x & y; });
+}
+
+void ior_n(block_t *r, const block_t *a, const block_t *b, size_t n) {
+  bitwise_n(r, a, b, n, [](auto x, auto y) { return x | y; });
+}
+
+void xor_n(block_t *r, const block_t *a, const block_t *b, size_t n) {
+  bitwise_n(r, a, b, n, [](auto x, auto y) { return x ^ y; });
+}
+
+void com(block_t *r, const block_t *a, size_t n) {
+  bitwise_n(r, a, a, n, [](auto x, auto) { return ~x; });
+}
+
+size_t popcount(const block_t *a, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+#if BLOCK_WIDTH == 64
+    count += static_cast<size_t>(__builtin_popcountll(a[i]));
+#else
+    count += static_cast<size_t>(__builtin_popcount(a[i]));
+#endif
+  }
+  return count;
+}
+
+} // namespace mpn
@@ -0,0 +1,267 @@
+#ifndef LAB_AINT_MPN_H_
+#define LAB_AINT_MPN_H_
+#include "aint.hpp"
+#include <cstddef>
+
+/**
+ * Low-level routines working on raw arrays of blocks (or limbs), used to
+ * implement the aint operations.
+ *
+ * @details
+ * Numbers are given as a pointer to their least significant block and a block
+ * count. Unless stated otherwise, counts may include "trailing" zero blocks and
+ * the result array must hold the maximal size of the result. Functions
+ * returning a block return the carry (or borrow) out of the most significant
+ * block.
+ *
+ * @note
+ * The functions taking a `scratch` array allocate nothing else, except for
+ * the number-theoretic transform and the Newton division used on the largest
+ * operands. Their `_itch` companion gives the size of the scratch array, which
+ * may be allocated once and reused by a loop. The variants without `scratch`
+ * allocate it themselves.
+ */
+namespace mpn {
+
+/**
+ * Limb-count thresholds used to select the multiplication algorithm. They are
+ * initialized from thresholds.hpp and may be changed at runtime.
+ */
+struct thresholds_t {
+  /**
+   * Smallest operand size from which Karatsuba multiplication is used.
+   */
+  size_t mul_karatsuba;
+  /**
+   * Smallest operand size from which Toom-3 multiplication is used.
+   */
+  size_t mul_toom3;
+  /**
+   * Smallest operand size from which number-theoretic transform
+   * multiplication is used.
+   */
+  size_t mul_ntt;
+  /**
+   * Smallest divisor and quotient size from which division by Newton
+   * reciprocal is used.
+   */
+  size_t div_newton;
+};
+extern thresholds_t thresholds;
+
+/**
+ * Opt-in multithreading of the large multiplications. The recursion branches
+ * of Karatsuba and Toom-3 multiplications, and the three prime transforms of
+ * the NTT multiplication, are then run on a shared thread pool. It must not be
+ * changed while a multiplication is running.
+ */
+struct parallel_t {
+  /**
+   * Number of threads working on a multiplication, the calling thread
+   * included. 1 (the default) keeps every multiplication on the calling
+   * thread.
+   */
+  unsigned threads;
+  /**
+   * Smallest operand size from which the branches are run on separate
+   * threads, smaller products staying on the thread computing them.
+   */
+  size_t mul_threshold;
+};
+extern parallel_t parallel;
+
+/**
+ * @return The number of blocks of `a`, excluding trailing zero blocks
+ */
+size_t normalized_size(const block_t *a, size_t n);
+/**
+ * Compares two numbers of `n` blocks.
+ * @return A negative value if a < b, zero if a == b, a positive value if a > b
+ */
+int cmp(const block_t *a, const block_t *b, size_t n);
+
+/**
+ * Computes r = a + b where both numbers have `n` blocks.
+ * @return The carry (0 or 1)
+ */
+block_t add_n(block_t *r, const block_t *a, const block_t *b, size_t n);
+/**
+ * Computes r = a + b, with `an` >= `bn`. The result has `an` blocks.
+ * @return The carry (0 or 1)
+ */
+block_t add(block_t *r, const block_t *a, size_t an, const block_t *b,
+            size_t bn);
+/**
+ * Computes r = a + u. The result has `n` blocks.
+ * @return The carry (0 or 1)
+ */
+block_t add_1(block_t *r, const block_t *a, size_t n, block_t u);
+/**
+ * Computes r = a - b where both numbers have `n` blocks.
+ * @return The borrow (0 or 1)
+ */
+block_t sub_n(block_t *r, const block_t *a, const block_t *b, size_t n);
+/**
+ * Computes r = a - b, with `an` >= `bn`. The result has `an` blocks.
+ * @return The borrow (0 or 1)
+ */
+block_t sub(block_t *r, const block_t *a, size_t an, const block_t *b,
+            size_t bn);
+/**
+ * Computes r = a - u. The result has `n` blocks.
+ * @return The borrow (0 or 1)
+ */
+block_t sub_1(block_t *r, const block_t *a, size_t n, block_t u);
+/**
+ * Computes r = a * u. The result has `n` blocks.
+ * @return The most significant block of the product
+ */
+block_t mul_1(block_t *r, const block_t *a, size_t n, block_t u);
+/**
+ * Computes r += a * u, `r` and `a` having `n` blocks.
+ * @return The block to add above the most significant block of `r`
+ */
+block_t addmul_1(block_t *r, const block_t *a, size_t n, block_t u);
+/**
+ * Computes r -= a * u, `r` and `a` having `n` blocks.
+ * @return The block to subtract above the most significant block of `r`
+ */
+block_t submul_1(block_t *r, const block_t *a, size_t n, block_t u);
+/**
+ * Computes r = a * 2^count, with 0 < `count` < BLOCK_WIDTH. The result has `n`
+ * blocks and may overlap `a` if r >= a.
+ * @return The bits shifted out of the most significant block
+ */
+block_t lshift(block_t *r, const block_t *a, size_t n, unsigned count);
+/**
+ * Computes r = a / 2^count, with 0 < `count` < BLOCK_WIDTH. The result has `n`
+ * blocks and may overlap `a` if r <= a.
+ * @return The bits shifted out of the least significant block, in the most
+ * significant bits of the returned block
+ */
+block_t rshift(block_t *r, const block_t *a, size_t n, unsigned count);
+
+/**
+ * Computes r = a & b, r = a | b and r = a ^ b where both numbers have `n`
+ * blocks, 128 bits at a time. The result may overlap the operands if r == a
+ * or r == b.
+ */
+void and_n(block_t *r, const block_t *a, const block_t *b, size_t n);
+void ior_n(block_t *r, const block_t *a, const block_t *b, size_t n);
+void xor_n(block_t *r, const block_t *a, const block_t *b, size_t n);
+/**
+ * Computes the ones' complement of a number of `n` blocks. The result may
+ * overlap `a` if r == a.
+ */
+void com(block_t *r, const block_t *a, size_t n);
+/**
+ * @return The number of bits set in a number of `n` blocks
+ */
+size_t popcount(const block_t *a, size_t n);
+
+/**
+ * Computes r = a * b with the schoolbook algorithm, accumulating the partial
+ * products in place. The result has `an + bn` blocks and must not overlap the
+ * operands.
+ */
+void mul_basecase(block_t *r, const block_t *a, size_t an, const block_t *b,
+                  size_t bn);
+/**
+ * Computes r = a * a with the schoolbook algorithm, computing each cross
+ * product once. The result has `2n` blocks and must not overlap the operand.
+ */
+void sqr_basecase(block_t *r, const block_t *a, size_t n);
+/**
+ * @return True if mpn::mul_ntt() supports operands of `an` and `bn` blocks
+ */
+bool mul_ntt_fits(size_t an, size_t bn);
+/**
+ * Computes r = a * b with a three-prime number-theoretic transform, the
+ * operands being cut into 32 bits digits. The result has `an + bn` blocks and
+ * must not overlap the operands.
+ * @throws std::bad_alloc Thrown if the transform buffers cannot be allocated
+ * @see mpn::mul_ntt_fits()
+ */
+void mul_ntt(block_t *r, const block_t *a, size_t an, const block_t *b,
+             size_t bn);
+/**
+ * @return The number of scratch blocks needed by mpn::mul() when the largest
+ * operand has `an` blocks
+ */
+size_t mul_itch(size_t an);
+/**
+ * @return The number of scratch blocks needed by mpn::mul() for operands of
+ * `an` >= `bn` blocks, zero if the algorithm chosen uses none
+ */
+size_t mul_itch(size_t an, size_t bn);
+/**
+ * @return The number of scratch blocks needed by mpn::sqr() for an operand of
+ * `n` blocks, zero if the algorithm chosen uses none
+ */
+size_t sqr_itch(size_t n);
+/**
+ * Computes r = a * b, with `an` >= `bn` >= 1, choosing the algorithm from the
+ * operand sizes. Identical operands are squared with mpn::sqr(). The result
+ * has `an + bn` blocks and must not overlap the operands.
+ * @param scratch Temporary storage of at least mpn::mul_itch(an, bn) blocks
+ */
+void mul(block_t *r, const block_t *a, size_t an, const block_t *b, size_t bn,
+         block_t *scratch);
+/**
+ * Computes r = a * b, allocating the temporary storage if needed.
+ * @see mpn::mul(block_t *, const block_t *, size_t, const block_t *, size_t,
+ * block_t *)
+ * @throws std::bad_alloc Thrown if the temporary storage cannot be allocated
+ */
+void mul(block_t *r, const block_t *a, size_t an, const block_t *b,
+         size_t bn);
+
+/**
+ * Computes r = a * a, with `n` >= 1, with the squaring variants of the
+ * multiplication algorithms. The result has `2n` blocks and must not overlap
+ * the operand.
+ * @param scratch Temporary storage of at least mpn::sqr_itch(n) blocks
+ */
+void sqr(block_t *r, const block_t *a, size_t n, block_t *scratch);
+/**
+ * Computes r = a * a, allocating the temporary storage if needed.
+ * @see mpn::sqr(block_t *, const block_t *, size_t, block_t *)
+ */
+void sqr(block_t *r, const block_t *a, size_t n);
+
+/**
+ * Computes q = a / u, where `a` has `n` blocks. The quotient has `n` blocks and
+ * may overlap `a`.
+ * @return The remainder a % u
+ */
+block_t divrem_1(block_t *q, const block_t *a, size_t n, block_t u);
+/**
+ * @return The number of scratch blocks needed by mpn::divrem()
+ */
+size_t divrem_itch(size_t an, size_t dn);
+/**
+ * Computes q = a / d and r = a % d, with `an` >= `dn` >= 1 and a non-zero most
+ * significant block in `d`. The quotient has `an - dn + 1` blocks, the
+ * remainder `dn` blocks, and neither may overlap the operands.
+ *
+ * @details
+ * Knuth's algorithm D is used unless both the divisor and the quotient reach
+ * thresholds_t::div_newton blocks, in which case the division is done by
+ * multiplying with a Newton reciprocal of the divisor (the scratch space is
+ * then unused and the temporary storage allocated).
+ * @param scratch Temporary storage of at least mpn::divrem_itch(an, dn) blocks
+ */
+void divrem(block_t *q, block_t *r, const block_t *a, size_t an,
+            const block_t *d, size_t dn, block_t *scratch);
+/**
+ * Computes q = a / d and r = a % d, allocating the temporary storage.
+ * @see mpn::divrem(block_t *, block_t *, const block_t *, size_t,
+ * const block_t *, size_t, block_t *)
+ * @throws std::bad_alloc Thrown if the temporary storage cannot be allocated
+ */
+void divrem(block_t *q, block_t *r, const block_t *a, size_t an,
+            const block_t *d, size_t dn);
+
+} // namespace mpn
+
+#endif // LAB_AINT_MPN_H_
@@ -0,0 +1,419 @@
+#include "mpn.hpp"
+#include "parallel.hpp"
+#include "thresholds.hpp"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mpn {
+
+thresholds_t thresholds = {AINT_MUL_KARATSUBA_THRESHOLD,
+                           AINT_MUL_TOOM3_THRESHOLD, AINT_MUL_NTT_THRESHOLD,
+                           AINT_DIV_NEWTON_THRESHOLD};
+
+/**
+ * The recursive algorithms need a minimal operand size for their scratch
+ * space estimation to hold, smaller thresholds are raised to it.
+ */
+static const size_t MUL_MIN_RECURSIVE_SIZE = 8;
+
+void mul_basecase(block_t *r, const block_t *a, size_t an, const block_t *b,
+                  size_t bn) {
+  r[an] = mul_1(r, a, an, b[0]);
+  for (size_t i = 1; i < bn; i++) {
+    r[an + i] = addmul_1(r + i, a, an, b[i]);
+  }
+}
+
+/**
+ * Each cross product a[i] * a[j] with i < j is computed once, the sum being
+ * doubled before the diagonal squares are added.
+ */
+void sqr_basecase(block_t *r, const block_t *a, size_t n) {
+  r[0] = 0;
+  r[2 * n - 1] = 0;
+  if (n > 1) {
+    r[n] = mul_1(r + 1, a + 1, n - 1, a[0]);
+    for (size_t i = 1; i + 1 < n; i++) {
+      r[n + i] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+    r[2 * n - 1] = lshift(r + 1, r + 1, 2 * n - 2, 1);
+  }
+  block_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    dblock_t square = static_cast<dblock_t>(a[i]) * a[i];
+    dblock_t sum = static_cast<dblock_t>(r[2 * i]) +
+                   static_cast<block_t>(square) + carry;
+    r[2 * i] = static_cast<block_t>(sum);
+    sum = static_cast<dblock_t>(r[2 * i + 1]) +
+          static_cast<block_t>(square >> BLOCK_WIDTH) +
+          static_cast<block_t>(sum >> BLOCK_WIDTH);
+    r[2 * i + 1] = static_cast<block_t>(sum);
+    carry = static_cast<block_t>(sum >> BLOCK_WIDTH);
+  }
+}
+
+/**
+ * The scratch space of the recursive algorithms is bounded by
+ * 4n + 32 + itch(n / 2 + 2): Karatsuba uses about 2n blocks before recursing
+ * on n / 2 + 1 blocks, Toom-3 about 4n blocks before recursing on n / 3 + 2.
+ */
+size_t mul_itch(size_t an) {
+  size_t itch = 0;
+  for (; an >= MUL_MIN_RECURSIVE_SIZE; an = an / 2 + 2) {
+    itch += 4 * an + 32;
+  }
+  return itch;
+}
+
+size_t mul_itch(size_t an, size_t bn) {
+  if ((bn >= thresholds.mul_ntt && mul_ntt_fits(an, bn)) ||
+      (bn < std::max(thresholds.mul_karatsuba, MUL_MIN_RECURSIVE_SIZE) &&
+       bn < std::max(thresholds.mul_toom3, MUL_MIN_RECURSIVE_SIZE))) {
+    return 0;
+  }
+  return mul_itch(an);
+}
+
+size_t sqr_itch(size_t n) { return mul_itch(n, n); }
+
+/**
+ * Computes r = |a - b| where both numbers have `n` blocks.
+ * @return True if the difference is negative
+ */
+static bool sub_abs_n(block_t *r, const block_t *a, const block_t *b,
+                      size_t n) {
+  for (size_t i = n; i > 0; i--) {
+    if (a[i - 1] != b[i - 1]) {
+      if (a[i - 1] > b[i - 1]) {
+        sub_n(r, a, b, n);
+        return false;
+      }
+      sub_n(r, b, a, n);
+      return true;
+    }
+  }
+  std::fill(r, r + n, 0);
+  return false;
+}
+
+/**
+ * Computes the product of a single piece of the operands of a recursive
+ * multiplication. Zero pieces are handled here as mpn::mul() expects non-empty
+ * operands.
+ */
+static void mul_piece(block_t *r, const block_t *a, size_t an,
+                      const block_t *b, size_t bn, block_t *scratch) {
+  size_t rn = an + bn;
+  an = normalized_size(a, an);
+  bn = normalized_size(b, bn);
+  if (an == 0 || bn == 0) {
+    std::fill(r, r + rn, 0);
+    return;
+  }
+  std::fill(r + an + bn, r + rn, 0);
+  if (an >= bn) {
+    mul(r, a, an, b, bn, scratch);
+  } else {
+    mul(r, b, bn, a, an, scratch);
+  }
+}
+
+/**
+ * Operands and result of a product of the recursive algorithms.
+ */
+struct piece_t {
+  block_t *r;
+  const block_t *a;
+  size_t an;
+  const block_t *b;
+  size_t bn;
+};
+
+/**
+ * Computes independent products of at most `n` blocks operands, one after the
+ * other on the same scratch space, or as separate tasks each with their own
+ * scratch space (the first one keeping the given one).
+ * @see mpn::parallel_t
+ */
+static void mul_pieces(const piece_t *pieces, size_t count, size_t n,
+                       block_t *scratch) {
+  if (!parallel_mul(n)) {
+    for (size_t i = 0; i < count; i++) {
+      const piece_t &piece = pieces[i];
+      mul_piece(piece.r, piece.a, piece.an, piece.b, piece.bn, scratch);
+    }
+    return;
+  }
+  std::vector<std::function<void()>> tasks;
+  for (size_t i = 0; i < count; i++) {
+    const piece_t &piece = pieces[i];
+    tasks.emplace_back([&piece, i, n, scratch]() {
+      std::unique_ptr<block_t[]> own_scratch;
+      if (i != 0) {
+        own_scratch.reset(new block_t[mul_itch(n)]);
+      }
+      mul_piece(piece.r, piece.a, piece.an, piece.b, piece.bn,
+                i == 0 ? scratch : own_scratch.get());
+    });
+  }
+  run_tasks(tasks.data(), tasks.size());
+}
+
+/**
+ * Multiplies operands of very different sizes (an + 1 >= 2 * bn) by cutting
+ * `a` into pieces of `bn` blocks.
+ */
+static void mul_unbalanced(block_t *r, const block_t *a, size_t an,
+                           const block_t *b, size_t bn, block_t *scratch) {
+  mul_piece(r, a, bn, b, bn, scratch);
+  block_t *product = scratch;
+  scratch += 2 * bn;
+  for (size_t offset = bn; offset < an; offset += bn) {
+    size_t piece_size = std::min(bn, an - offset);
+    mul_piece(product, a + offset, piece_size, b, bn, scratch);
+    // The lower half overlaps the previous product, the upper half is new.
+    block_t carry = add_n(r + offset, r + offset, product, bn);
+    std::copy(product + bn, product + bn + piece_size, r + offset + bn);
+    add_1(r + offset + bn, r + offset + bn, piece_size, carry);
+  }
+}
+
+/**
+ * Karatsuba multiplication, with bn <= an < 2 * bn - 1.
+ *
+ * @details
+ * With a = a1 * B^h + a0 and b = b1 * B^h + b0:
+ * a * b = z2 * B^2h + ((a0 + a1)(b0 + b1) - z2 - z0) * B^h + z0
+ * where z0 = a0 * b0 and z2 = a1 * b1. The three products are squares when
+ * both operands are the same.
+ */
+static void mul_karatsuba(block_t *r, const block_t *a, size_t an,
+                          const block_t *b, size_t bn, block_t *scratch) {
+  size_t h = (an + 1) / 2;
+  size_t a1n = an - h, b1n = bn - h;
+  block_t *sa = scratch;
+  block_t *sb = sa + h + 1;
+  block_t *z1 = sb + h + 1;
+  sa[h] = add(sa, a, h, a + h, a1n);
+  if (a == b && an == bn) {
+    // A square only needs (a0 + a1)^2.
+    sb = sa;
+  } else {
+    sb[h] = add(sb, b, h, b + h, b1n);
+  }
+  // z0 and z2 are directly computed in their final place.
+  const piece_t pieces[] = {{z1, sa, h + 1, sb, h + 1},
+                            {r, a, h, b, h},
+                            {r + 2 * h, a + h, a1n, b + h, b1n}};
+  mul_pieces(pieces, 3, h + 1, z1 + 2 * h + 2);
+  sub(z1, z1, 2 * h + 2, r, 2 * h);
+  sub(z1, z1, 2 * h + 2, r + 2 * h, a1n + b1n);
+  // z1 * B^h is lower than the result, its extra blocks are zero.
+  size_t z1n = std::min(2 * h + 2, an + bn - h);
+  add(r + h, r + h, an + bn - h, z1, z1n);
+}
+
+/**
+ * Divides a two's complement number by 2, the division being exact.
+ */
+static void rshift1_signed(block_t *r, size_t n) {
+  for (size_t i = 0; i + 1 < n; i++) {
+    r[i] = (r[i] >> 1) | (r[i + 1] << (BLOCK_WIDTH - 1));
+  }
+  r[n - 1] = (r[n - 1] >> 1) | (r[n - 1] & (static_cast<block_t>(1)
+                                            << (BLOCK_WIDTH - 1)));
+}
+
+/**
+ * Divides a two's complement number by 3, the division being exact. The
+ * quotient is the product with the inverse of 3 modulo B^n.
+ */
+static void divexact_by3(block_t *r, size_t n) {
+  const block_t inverse = BLOCK_MAX / 3 * 2 + 1;
+  block_t carry = 0;
+  for (size_t i = 0; i < n; i++) {
+    block_t block = r[i];
+    block_t borrow = block < carry;
+    block -= carry;
+    block_t quotient = block * inverse;
+    r[i] = quotient;
+    // 3 * quotient = block + high * B.
+    carry = static_cast<block_t>((static_cast<dblock_t>(quotient) * 3) >>
+                                 BLOCK_WIDTH) +
+            borrow;
+  }
+}
+
+/**
+ * Negates a two's complement number.
+ */
+static void neg(block_t *r, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    r[i] = ~r[i];
+  }
+  add_1(r, r, n, 1);
+}
+
+/**
+ * Evaluates a three pieces operand at 1, -1 and -2. Each value has k + 1
+ * blocks, the values at -1 and -2 being stored as magnitude and sign.
+ * @param tmp Temporary storage of 2 * (k + 1) blocks
+ */
+static void toom3_evaluate(const block_t *a, size_t k, size_t a2n,
+                           block_t *at1, block_t *atm1, bool &negm1,
+                           block_t *atm2, bool &negm2, block_t *tmp) {
+  const block_t *a1 = a + k, *a2 = a + 2 * k;
+  // a0 + a2, then a(1) = a0 + a1 + a2 and a(-1) = a0 + a2 - a1.
+  at1[k] = add(at1, a, k, a2, a2n);
+  tmp[k] = 0;
+  std::copy(a1, a1 + k, tmp);
+  negm1 = sub_abs_n(atm1, at1, tmp, k + 1);
+  at1[k] += add_n(at1, at1, a1, k);
+  // a(-2) = a0 + 4 * a2 - 2 * a1.
+  block_t *pos = tmp, *sub2 = tmp + k + 1;
+  std::fill(pos, pos + k + 1, 0);
+  std::copy(a2, a2 + a2n, pos);
+  lshift(pos, pos, k + 1, 2);
+  add(pos, pos, k + 1, a, k);
+  std::copy(a1, a1 + k, sub2);
+  sub2[k] = 0;
+  lshift(sub2, sub2, k + 1, 1);
+  negm2 = sub_abs_n(atm2, pos, sub2, k + 1);
+}
+
+/**
+ * Toom-3 multiplication, with evaluation at 0, 1, -1, -2 and infinity and
+ * Bodrato's interpolation sequence. Requires 2 * ceil(an / 3) < bn <= an.
+ *
+ * @details
+ * The interpolation is done on two's complement numbers of 2k + 3 blocks,
+ * large enough to hold every intermediate value.
+ */
+static void mul_toom3(block_t *r, const block_t *a, size_t an,
+                      const block_t *b, size_t bn, block_t *scratch) {
+  size_t k = (an + 2) / 3;
+  size_t a2n = an - 2 * k, b2n = bn - 2 * k;
+  size_t p = k + 1, l = 2 * k + 3;
+  block_t *at1 = scratch, *atm1 = at1 + p, *atm2 = atm1 + p;
+  block_t *bt1 = atm2 + p, *btm1 = bt1 + p, *btm2 = btm1 + p;
+  block_t *r1 = btm2 + p, *rm1 = r1 + l, *rm2 = rm1 + l;
+  block_t *next = rm2 + l;
+  bool nega1, nega2, negb1, negb2;
+  toom3_evaluate(a, k, a2n, at1, atm1, nega1, atm2, nega2, rm2);
+  if (a == b && an == bn) {
+    // The evaluations of a square are shared, the five products are squares.
+    bt1 = at1;
+    btm1 = atm1;
+    btm2 = atm2;
+    negb1 = nega1;
+    negb2 = nega2;
+  } else {
+    toom3_evaluate(b, k, b2n, bt1, btm1, negb1, btm2, negb2, rm2);
+  }
+
+  // r(0) and r(infinity) are directly computed in their final place.
+  const piece_t pieces[] = {{r1, at1, p, bt1, p},
+                            {rm1, atm1, p, btm1, p},
+                            {rm2, atm2, p, btm2, p},
+                            {r, a, k, b, k},
+                            {r + 4 * k, a + 2 * k, a2n, b + 2 * k, b2n}};
+  mul_pieces(pieces, 5, p, next);
+  r1[l - 1] = 0;
+  rm1[l - 1] = 0;
+  rm2[l - 1] = 0;
+  if (nega1 != negb1) {
+    neg(rm1, l);
+  }
+  if (nega2 != negb2) {
+    neg(rm2, l);
+  }
+
+  const block_t *r0 = r, *rinf = r + 4 * k;
+  size_t rinfn = a2n + b2n;
+  // r3 = (r(-2) - r(1)) / 3
+  block_t *r3 = rm2;
+  sub_n(r3, rm2, r1, l);
+  divexact_by3(r3, l);
+  // r1 = (r(1) - r(-1)) / 2
+  sub_n(r1, r1, rm1, l);
+  rshift1_signed(r1, l);
+  // r2 = r(-1) - r(0)
+  block_t *r2 = rm1;
+  sub(r2, rm1, l, r0, 2 * k);
+  // r3 = (r2 - r3) / 2 + 2 * r(infinity)
+  sub_n(r3, r2, r3, l);
+  rshift1_signed(r3, l);
+  add(r3, r3, l, rinf, rinfn);
+  add(r3, r3, l, rinf, rinfn);
+  // r2 = r2 + r1 - r(infinity)
+  add_n(r2, r2, r1, l);
+  sub(r2, r2, l, rinf, rinfn);
+  // r1 = r1 - r3
+  sub_n(r1, r1, r3, l);
+
+  // The coefficients are the non-negative values of the product polynomial.
+  size_t rn = an + bn;
+  std::fill(r + 2 * k, r + 4 * k, 0);
+  add(r + k, r + k, rn - k, r1, std::min(normalized_size(r1, l), rn - k));
+  add(r + 2 * k, r + 2 * k, rn - 2 * k, r2,
+      std::min(normalized_size(r2, l), rn - 2 * k));
+  add(r + 3 * k, r + 3 * k, rn - 3 * k, r3,
+      std::min(normalized_size(r3, l), rn - 3 * k));
+}
+
+void sqr(block_t *r, const block_t *a, size_t n, block_t *scratch) {
+  size_t karatsuba_threshold =
+      std::max(thresholds.mul_karatsuba, MUL_MIN_RECURSIVE_SIZE);
+  size_t toom3_threshold =
+      std::max(thresholds.mul_toom3, MUL_MIN_RECURSIVE_SIZE);
+  if (n >= thresholds.mul_ntt && mul_ntt_fits(n, n)) {
+    mul_ntt(r, a, n, a, n);
+  } else if (n < karatsuba_threshold && n < toom3_threshold) {
+    sqr_basecase(r, a, n);
+  } else if (n >= toom3_threshold) {
+    mul_toom3(r, a, n, a, n, scratch);
+  } else {
+    mul_karatsuba(r, a, n, a, n, scratch);
+  }
+}
+
+void sqr(block_t *r, const block_t *a, size_t n) {
+  size_t itch = sqr_itch(n);
+  std::unique_ptr<block_t[]> scratch(itch != 0 ? new block_t[itch] : nullptr);
+  sqr(r, a, n, scratch.get());
+}
+
+void mul(block_t *r, const block_t *a, size_t an, const block_t *b, size_t bn,
+         block_t *scratch) {
+  if (a == b && an == bn) {
+    sqr(r, a, an, scratch);
+    return;
+  }
+  size_t karatsuba_threshold =
+      std::max(thresholds.mul_karatsuba, MUL_MIN_RECURSIVE_SIZE);
+  size_t toom3_threshold =
+      std::max(thresholds.mul_toom3, MUL_MIN_RECURSIVE_SIZE);
+  if (bn >= thresholds.mul_ntt && mul_ntt_fits(an, bn)) {
+    mul_ntt(r, a, an, b, bn);
+  } else if (bn < karatsuba_threshold && bn < toom3_threshold) {
+    mul_basecase(r, a, an, b, bn);
+  } else if (an + 1 >= 2 * bn) {
+    mul_unbalanced(r, a, an, b, bn, scratch);
+  } else if (bn >= toom3_threshold && bn > 2 * ((an + 2) / 3)) {
+    mul_toom3(r, a, an, b, bn, scratch);
+  } else {
+    mul_karatsuba(r, a, an, b, bn, scratch);
+  }
+}
+
+void mul(block_t *r, const block_t *a, size_t an, const block_t *b,
+         size_t bn) {
+  size_t itch = mul_itch(an, bn);
+  std::unique_ptr<block_t[]> scratch(itch != 0 ? new block_t[itch] : nullptr);
+  mul(r, a, an, b, bn, scratch.get());
+}
+
+} // namespace mpn
@@ -0,0 +1,229 @@
+#include "mpn.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace mpn {
+
+/**
+ * The operands are cut into 32 bits digits, independently of the block width.
+ */
+static const unsigned DIGIT_WIDTH = 32;
+static const size_t DIGITS_PER_BLOCK = BLOCK_WIDTH / DIGIT_WIDTH;
+static_assert(BLOCK_WIDTH % DIGIT_WIDTH == 0,
+              "the block width must be a multiple of the NTT digit width");
+
+/**
+ * Largest transform length supported by all three primes (2^23 divides
+ * P1 - 1). The convolution coefficients are then lower than
+ * 2^22 * (2^32)^2 < P1 * P2 * P3, so the CRT reconstruction is exact.
+ */
+static const size_t NTT_MAX_LENGTH = static_cast<size_t>(1) << 23;
+
+static const uint32_t P1 = 998244353;  // 119 * 2^23 + 1
+static const uint32_t P2 = 167772161;  // 5 * 2^25 + 1
+static const uint32_t P3 = 469762049;  // 7 * 2^26 + 1
+static const uint32_t GENERATOR = 3;   // Primitive root of all three primes.
+
+template <uint32_t P> static inline uint32_t mulmod(uint32_t a, uint32_t b) {
+  return static_cast<uint32_t>(static_cast<uint64_t>(a) * b % P);
+}
+
+template <uint32_t P> static inline uint32_t addmod(uint32_t a, uint32_t b) {
+  uint32_t sum = a + b;
+  return sum >= P ? sum - P : sum;
+}
+
+template <uint32_t P> static inline uint32_t submod(uint32_t a, uint32_t b) {
+  return a >= b ? a - b : a + P - b;
+}
+
+template <uint32_t P> static uint32_t powmod(uint32_t a, uint64_t e) {
+  uint32_t result = 1;
+  for (; e != 0; e >>= 1) {
+    if (e & 1) {
+      result = mulmod<P>(result, a);
+    }
+    a = mulmod<P>(a, a);
+  }
+  return result;
+}
+
+/**
+ * Fills `roots` so that roots[half + j] = w^j, w being a primitive
+ * (2 * half)-th root of unity (or its inverse), for every power of two `half`
+ * lower than `n`.
+ */
+template <uint32_t P>
+static void ntt_roots(uint32_t *roots, size_t n, bool inverse) {
+  for (size_t half = 1; half < n; half *= 2) {
+    uint32_t w = powmod<P>(GENERATOR, (P - 1) / (2 * half));
+    if (inverse) {
+      w = powmod<P>(w, P - 2);
+    }
+    roots[half] = 1;
+    for (size_t j = 1; j < half; j++) {
+      roots[half + j] = mulmod<P>(roots[half + j - 1], w);
+    }
+  }
+}
+
+/**
+ * Decimation-in-frequency transform: natural order input, bit-reversed order
+ * output.
+ */
+template <uint32_t P>
+static void ntt_forward(uint32_t *a, size_t n, const uint32_t *roots) {
+  for (size_t half = n / 2; half >= 1; half /= 2) {
+    for (size_t start = 0; start < n; start += 2 * half) {
+      uint32_t *x = a + start, *y = x + half;
+      for (size_t j = 0; j < half; j++) {
+        uint32_t u = x[j], v = y[j];
+        x[j] = addmod<P>(u, v);
+        y[j] = mulmod<P>(submod<P>(u, v), roots[half + j]);
+      }
+    }
+  }
+}
+
+/**
+ * Decimation-in-time inverse transform: bit-reversed order input, natural
+ * order output, including the division by `n`.
+ */
+template <uint32_t P>
+static void ntt_inverse(uint32_t *a, size_t n, const uint32_t *roots) {
+  for (size_t half = 1; half < n; half *= 2) {
+    for (size_t start = 0; start < n; start += 2 * half) {
+      uint32_t *x = a + start, *y = x + half;
+      for (size_t j = 0; j < half; j++) {
+        uint32_t u = x[j], v = mulmod<P>(y[j], roots[half + j]);
+        x[j] = addmod<P>(u, v);
+        y[j] = submod<P>(u, v);
+      }
+    }
+  }
+  uint32_t n_inverse = powmod<P>(static_cast<uint32_t>(n % P), P - 2);
+  for (size_t i = 0; i < n; i++) {
+    a[i] = mulmod<P>(a[i], n_inverse);
+  }
+}
+
+/**
+ * Splits blocks into zero-padded digits reduced modulo P.
+ */
+template <uint32_t P>
+static void ntt_load(uint32_t *digits, size_t n, const block_t *a,
+                     size_t an) {
+  size_t i = 0;
+  for (size_t block_index = 0; block_index < an; block_index++) {
+    block_t block = a[block_index];
+    for (size_t d = 0; d < DIGITS_PER_BLOCK; d++, i++) {
+      digits[i] = static_cast<uint32_t>(block) % P;
+      block = static_cast<block_t>(block >> (DIGIT_WIDTH - 1) >> 1);
+    }
+  }
+  std::fill(digits + i, digits + n, 0);
+}
+
+/**
+ * Computes the cyclic convolution of a and b modulo P into `result`. A square
+ * only needs one forward transform.
+ * @param tmp Temporary storage of `n` digits
+ * @param roots Temporary storage of `n` digits
+ */
+template <uint32_t P>
+static void ntt_convolve(uint32_t *result, const block_t *a, size_t an,
+                         const block_t *b, size_t bn, size_t n, uint32_t *tmp,
+                         uint32_t *roots) {
+  ntt_roots<P>(roots, n, false);
+  ntt_load<P>(result, n, a, an);
+  ntt_forward<P>(result, n, roots);
+  if (a == b && an == bn) {
+    for (size_t i = 0; i < n; i++) {
+      result[i] = mulmod<P>(result[i], result[i]);
+    }
+  } else {
+    ntt_load<P>(tmp, n, b, bn);
+    ntt_forward<P>(tmp, n, roots);
+    for (size_t i = 0; i < n; i++) {
+      result[i] = mulmod<P>(result[i], tmp[i]);
+    }
+  }
+  ntt_roots<P>(roots, n, true);
+  ntt_inverse<P>(result, n, roots);
+}
+
+bool mul_ntt_fits(size_t an, size_t bn) {
+  return an + bn <= NTT_MAX_LENGTH / DIGITS_PER_BLOCK;
+}
+
+/**
+ * The convolution is done modulo three primes, the coefficients being then
+ * rebuilt with Garner's algorithm and accumulated digit by digit.
+ */
+void mul_ntt(block_t *r, const block_t *a, size_t an, const block_t *b,
+             size_t bn) {
+  size_t digit_count = (an + bn) * DIGITS_PER_BLOCK;
+  size_t n = 1;
+  for (; n < digit_count; n *= 2) {
+  }
+  // The three convolutions are independent, each one gets its own temporary
+  // storage when they run in parallel.
+  bool parallel_primes = parallel_mul(bn);
+  std::unique_ptr<uint32_t[]> buffer(
+      new uint32_t[(parallel_primes ? 9 : 5) * n]);
+  uint32_t *c1 = buffer.get(), *c2 = c1 + n, *c3 = c2 + n;
+  uint32_t *tmp1 = c3 + n, *tmp2 = tmp1, *tmp3 = tmp1;
+  if (parallel_primes) {
+    tmp2 = tmp1 + 2 * n;
+    tmp3 = tmp2 + 2 * n;
+  }
+  const std::function<void()> convolutions[] = {
+      [=]() { ntt_convolve<P1>(c1, a, an, b, bn, n, tmp1, tmp1 + n); },
+      [=]() { ntt_convolve<P2>(c2, a, an, b, bn, n, tmp2, tmp2 + n); },
+      [=]() { ntt_convolve<P3>(c3, a, an, b, bn, n, tmp3, tmp3 + n); }};
+  if (parallel_primes) {
+    run_tasks(convolutions, 3);
+  } else {
+    for (const auto &convolution : convolutions) {
+      convolution();
+    }
+  }
+
+  const uint32_t p1_inverse_p2 = powmod<P2>(P1 % P2, P2 - 2);
+  const uint64_t p1p2 = static_cast<uint64_t>(P1) * P2;
+  const uint32_t p1p2_inverse_p3 =
+      powmod<P3>(static_cast<uint32_t>(p1p2 % P3), P3 - 2);
+  const uint64_t p1p2_low = p1p2 & UINT32_MAX, p1p2_high = p1p2 >> 32;
+  // Pending value carry0 + carry1 * 2^32 + carry2 * 2^64.
+  uint64_t carry0 = 0, carry1 = 0, carry2 = 0;
+  size_t block_index = 0, digit_index = 0;
+  block_t block = 0;
+  for (size_t i = 0; i < digit_count; i++) {
+    // x = v + P1 * P2 * t, with v = x mod P1 * P2 and t < P3.
+    uint32_t y = mulmod<P2>(submod<P2>(c2[i], c1[i] % P2), p1_inverse_p2);
+    uint64_t v = c1[i] + static_cast<uint64_t>(P1) * y;
+    uint32_t t = mulmod<P3>(
+        submod<P3>(c3[i], static_cast<uint32_t>(v % P3)), p1p2_inverse_p3);
+    uint64_t low = p1p2_low * t, high = p1p2_high * t;
+    carry0 += (v & UINT32_MAX) + (low & UINT32_MAX);
+    carry1 += (v >> 32) + (low >> 32) + (high & UINT32_MAX);
+    carry2 += high >> 32;
+
+    block |= static_cast<block_t>(static_cast<block_t>(carry0 & UINT32_MAX)
+                                  << (DIGIT_WIDTH * digit_index));
+    carry1 += carry0 >> 32;
+    carry0 = carry1;
+    carry1 = carry2;
+    carry2 = 0;
+    if (++digit_index == DIGITS_PER_BLOCK) {
+      r[block_index++] = block;
+      block = 0;
+      digit_index = 0;
+    }
+  }
+}
+
+} // namespace mpn
@@ -0,0 +1,146 @@
+#include "parallel.hpp"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mpn {
+
+parallel_t parallel = {1, 1024};
+
+/**
+ * Whether the calling thread is running a task, the pool being then left as it
+ * is.
+ */
+static thread_local bool running_task = false;
+
+/**
+ * A task of a run_tasks() call, with the state shared by the tasks of the
+ * call.
+ */
+struct pool_task {
+  const std::function<void()> *body;
+  size_t *pending;
+  std::exception_ptr *error;
+};
+
+/**
+ * Workers running the queued tasks. Threads waiting for their tasks run queued
+ * tasks too instead of blocking while the queue is not empty.
+ */
+class thread_pool {
+  std::mutex mutex_;
+  /**
+   * Notified when a task is queued or the workers are stopped.
+   */
+  std::condition_variable work_;
+  /**
+   * Notified when a task is queued or done.
+   */
+  std::condition_variable progress_;
+  std::deque<pool_task> queue_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+
+  /**
+   * Runs a task with the mutex released.
+   */
+  void execute(const pool_task &task, std::unique_lock<std::mutex> &lock) {
+    lock.unlock();
+    bool was_running_task = running_task;
+    running_task = true;
+    std::exception_ptr error;
+    try {
+      (*task.body)();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    running_task = was_running_task;
+    lock.lock();
+    if (error && !*task.error) {
+      *task.error = error;
+    }
+    --*task.pending;
+    this->progress_.notify_all();
+  }
+
+  void work() {
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    while (true) {
+      this->work_.wait(
+          lock, [this]() { return this->stopping_ || !this->queue_.empty(); });
+      if (this->queue_.empty()) {
+        return;
+      }
+      pool_task task = this->queue_.front();
+      this->queue_.pop_front();
+      this->execute(task, lock);
+    }
+  }
+
+public:
+  thread_pool() = default;
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex_);
+      this->stopping_ = true;
+    }
+    this->work_.notify_all();
+    for (std::thread &worker : this->workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Runs the tasks with the help of `workers` workers. The workers are only
+   * started, under the mutex, by threads that are not running a task, and are
+   * kept until the pool is destroyed: lowering the number of workers leaves
+   * some of them idle.
+   */
+  void run(const std::function<void()> *tasks, size_t count, size_t workers) {
+    size_t pending = count;
+    std::exception_ptr error;
+    std::unique_lock<std::mutex> lock(this->mutex_);
+    if (!running_task) {
+      while (this->workers_.size() < workers) {
+        this->workers_.emplace_back(&thread_pool::work, this);
+      }
+    }
+    for (size_t i = 1; i < count; i++) {
+      this->queue_.push_back({tasks + i, &pending, &error});
+    }
+    this->work_.notify_all();
+    this->progress_.notify_all();
+    this->execute({tasks, &pending, &error}, lock);
+    while (pending != 0) {
+      if (this->queue_.empty()) {
+        this->progress_.wait(lock);
+        continue;
+      }
+      pool_task task = this->queue_.front();
+      this->queue_.pop_front();
+      this->execute(task, lock);
+    }
+    lock.unlock();
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+void run_tasks(const std::function<void()> *tasks, size_t count) {
+  if (parallel.threads <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; i++) {
+      tasks[i]();
+    }
+    return;
+  }
+  static thread_pool pool;
+  pool.run(tasks, count, parallel.threads - 1);
+}
+
+} // namespace mpn
@@ -0,0 +1,29 @@
+#ifndef LAB_AINT_PARALLEL_H_
+#define LAB_AINT_PARALLEL_H_
+#include "mpn.hpp"
+#include <functional>
+
+namespace mpn {
+
+/**
+ * @return True if a product whose smallest operand has `n` blocks is split
+ * across threads
+ * @see mpn::parallel_t
+ */
+inline bool parallel_mul(size_t n) {
+  return parallel.threads > 1 && n >= parallel.mul_threshold;
+}
+
+/**
+ * Runs independent tasks on the thread pool, which is given
+ * parallel_t::threads - 1 workers when it has fewer. The first task is run by
+ * the calling thread, which then runs queued tasks until all of its own are
+ * done, so that tasks may themselves wait for nested tasks.
+ * @throws Rethrows the first exception thrown by a task, once all of them are
+ * done
+ */
+void run_tasks(const std::function<void()> *tasks, size_t count);
+
+} // namespace mpn
+
+#endif // LAB_AINT_PARALLEL_H_
@@ -0,0 +1,264 @@
+#include "aint.hpp"
+#include "arena.hpp"
+#include "parallel.hpp"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Below this n, factorial() multiplies 2, ..., n directly instead of using the
+ * prime swing.
+ */
+static const block_t FACTORIAL_SWING_THRESHOLD = 256;
+/**
+ * binomial() factors the binomial over the primes up to n, which sieves all of
+ * them, only when k >= n / BINOMIAL_KUMMER_RATIO. Below, it divides
+ * n (n - 1) ... (n - k + 1) by k!, whose cost only depends on k.
+ */
+static const block_t BINOMIAL_KUMMER_RATIO = 16;
+
+/**
+ * Multiplies factors of a single block into full blocks, the leaves of a
+ * product tree, so that the tree starts from products of about BLOCK_WIDTH
+ * bits.
+ */
+class leaf_packer {
+  std::vector<aint> &leaves_;
+  block_t block_ = 1;
+
+public:
+  explicit leaf_packer(std::vector<aint> &leaves) : leaves_(leaves) {}
+
+  void push(block_t u) {
+    dblock_t product = static_cast<dblock_t>(this->block_) * u;
+    if (product > BLOCK_MAX) {
+      this->leaves_.emplace_back(this->block_);
+      this->block_ = u;
+    } else {
+      this->block_ = static_cast<block_t>(product);
+    }
+  }
+
+  void flush() {
+    if (this->block_ != 1) {
+      this->leaves_.emplace_back(this->block_);
+      this->block_ = 1;
+    }
+  }
+};
+
+/**
+ * Memory resource serializing the allocations made in another resource, which
+ * may not be thread-safe, such as the one of an aint_arena.
+ */
+class locked_resource : public std::pmr::memory_resource {
+  std::pmr::memory_resource *upstream_;
+  std::mutex mutex_;
+
+public:
+  explicit locked_resource(std::pmr::memory_resource *upstream)
+      : upstream_(upstream) {}
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    return this->upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    std::lock_guard<std::mutex> lock(this->mutex_);
+    this->upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+/**
+ * The factors are multiplied pairwise into a new level until one remains. The
+ * products of a level are independent: once the factors reach
+ * mpn::parallel_t::mul_threshold blocks, they are split into one range per
+ * thread.
+ *
+ * The products are allocated from the default resource of the calling thread,
+ * whichever thread computes them. When several threads may share it, they go
+ * through a locked_resource, the result being copied back into the resource
+ * itself.
+ */
+aint aint::product_tree(std::vector<aint> &factors) {
+  if (factors.empty()) {
+    return aint(1u);
+  }
+  std::pmr::memory_resource *resource = aint::default_resource();
+  locked_resource locked(resource);
+  if (resource != nullptr && mpn::parallel.threads > 1) {
+    resource = &locked;
+  }
+  // Declared after the locked resource, the levels are destroyed before it.
+  std::vector<aint> level, next;
+  std::vector<aint> *operands = &factors;
+  while (operands->size() > 1) {
+    size_t pairs = operands->size() / 2;
+    next.clear();
+    for (size_t i = 0; i < (operands->size() + 1) / 2; i++) {
+      next.emplace_back(resource);
+    }
+    if (operands->size() % 2 != 0) {
+      next.back() = std::move(operands->back());
+    }
+    auto multiply = [operands, &next, resource](size_t first, size_t last) {
+      aint_resource_scope scope(resource);
+      for (size_t i = first; i < last; i++) {
+        next[i] = (*operands)[2 * i] * (*operands)[2 * i + 1];
+      }
+    };
+    size_t smallest = operands->front().size();
+    for (const aint &factor : *operands) {
+      smallest = std::min(smallest, factor.size());
+    }
+    size_t ranges = std::min<size_t>(mpn::parallel.threads, pairs);
+    if (ranges > 1 && mpn::parallel_mul(smallest)) {
+      std::vector<std::function<void()>> tasks;
+      for (size_t r = 0; r < ranges; r++) {
+        size_t first = pairs * r / ranges, last = pairs * (r + 1) / ranges;
+        tasks.emplace_back(
+            [&multiply, first, last]() { multiply(first, last); });
+      }
+      mpn::run_tasks(tasks.data(), tasks.size());
+    } else {
+      multiply(0, pairs);
+    }
+    level.swap(next);
+    operands = &level;
+  }
+  aint product;
+  product = std::move(operands->front());
+  return product;
+}
+
+/**
+ * Sieve of Eratosthenes.
+ * @return The primes lower than or equal to n
+ */
+static std::vector<block_t> primes_up_to(block_t n) {
+  std::vector<block_t> primes;
+  if (n < 2) {
+    return primes;
+  }
+  std::vector<bool> composite(static_cast<size_t>(n) + 1, false);
+  for (size_t p = 2; p <= n; p++) {
+    if (composite[p]) {
+      continue;
+    }
+    primes.push_back(static_cast<block_t>(p));
+    for (size_t multiple = p * p; multiple <= n; multiple += p) {
+      composite[multiple] = true;
+    }
+  }
+  return primes;
+}
+
+/**
+ * @return lo * (lo + 1) * ... * hi, 1 if lo > hi
+ */
+static aint range_product(block_t lo, block_t hi) {
+  std::vector<aint> leaves;
+  leaf_packer packer(leaves);
+  for (block_t i = lo; i <= hi; i++) {
+    packer.push(i);
+    // Prevents the overflow of i when hi is BLOCK_MAX.
+    if (i == hi) {
+      break;
+    }
+  }
+  packer.flush();
+  return aint::product(std::make_move_iterator(leaves.begin()),
+                       std::make_move_iterator(leaves.end()));
+}
+
+/**
+ * The swing n! / (n/2)!^2 is the product of the primes p <= n raised to the
+ * sum of the parities of n / p^i.
+ */
+static aint prime_swing(block_t n, const std::vector<block_t> &primes) {
+  std::vector<aint> leaves;
+  leaf_packer packer(leaves);
+  for (block_t p : primes) {
+    if (p > n) {
+      break;
+    }
+    for (block_t q = n / p; q != 0; q /= p) {
+      if (q & 1) {
+        packer.push(p);
+      }
+    }
+  }
+  packer.flush();
+  return aint::product(std::make_move_iterator(leaves.begin()),
+                       std::make_move_iterator(leaves.end()));
+}
+
+/**
+ * n! = (n/2)!^2 * swing(n).
+ */
+static aint factorial_swing(block_t n, const std::vector<block_t> &primes) {
+  if (n < FACTORIAL_SWING_THRESHOLD) {
+    return range_product(2, n);
+  }
+  return square(factorial_swing(n / 2, primes)) * prime_swing(n, primes);
+}
+
+aint factorial(block_t n) {
+  if (n < FACTORIAL_SWING_THRESHOLD) {
+    return range_product(2, n);
+  }
+  return factorial_swing(n, primes_up_to(n));
+}
+
+/**
+ * Each prime p <= n divides the binomial as many times as there are borrows
+ * when subtracting k from n in base p (Kummer's theorem), which is the sum of
+ * n / p^i - k / p^i - (n - k) / p^i.
+ */
+aint binomial(block_t n, block_t k) {
+  if (k > n) {
+    return aint();
+  }
+  k = std::min(k, n - k);
+  if (k == 0) {
+    return aint(1u);
+  }
+  if (k < n / BINOMIAL_KUMMER_RATIO) {
+    return range_product(n - k + 1, n) / factorial(k);
+  }
+  std::vector<aint> leaves;
+  leaf_packer packer(leaves);
+  for (block_t p : primes_up_to(n)) {
+    for (block_t a = n / p, b = k / p, c = (n - k) / p; a != 0;
+         a /= p, b /= p, c /= p) {
+      for (block_t e = a - b - c; e != 0; e--) {
+        packer.push(p);
+      }
+    }
+  }
+  packer.flush();
+  return aint::product(std::make_move_iterator(leaves.begin()),
+                       std::make_move_iterator(leaves.end()));
+}
+
+aint primorial(block_t n) {
+  std::vector<aint> leaves;
+  leaf_packer packer(leaves);
+  for (block_t p : primes_up_to(n)) {
+    packer.push(p);
+  }
+  packer.flush();
+  return aint::product(std::make_move_iterator(leaves.begin()),
+                       std::make_move_iterator(leaves.end()));
+}
@@ -0,0 +1,107 @@
+#include "aint.hpp"
+#include <cmath>
+#include <utility>
+
+/**
+ * @return base^exponent by square-and-multiply
+ */
+static aint power(const aint &base, unsigned exponent) {
+  aint result = 1u, factor = base;
+  for (; exponent != 0; exponent >>= 1) {
+    if (exponent & 1) {
+      result *= factor;
+    }
+    if (exponent > 1) {
+      factor = square(factor);
+    }
+  }
+  return result;
+}
+
+/**
+ * Residues of the squares modulo m.
+ */
+struct square_residues {
+  block_t modulus;
+  bool residue[65];
+
+  explicit square_residues(block_t m) : modulus(m), residue() {
+    for (block_t x = 0; x < m; x++) {
+      this->residue[x * x % m] = true;
+    }
+  }
+};
+
+aint iroot(const aint &a, unsigned k) {
+  if (k == 0) {
+    throw std::invalid_argument("k");
+  }
+  if (a.zero() || k == 1) {
+    return a;
+  }
+  size_t bits = a.bit_length();
+  if (bits <= k) {
+    return aint(1u);
+  }
+
+  // Any x >= floor(a^(1/k)) starts the decreasing iteration.
+  aint x;
+  size_t shift = bits / k / 2;
+  if (bits <= 2 * BLOCK_WIDTH) {
+    dblock_t value = a.blocks_[0];
+    if (a.size() > 1) {
+      value |= static_cast<dblock_t>(a.blocks_[1]) << BLOCK_WIDTH;
+    }
+    long double estimate =
+        std::pow(static_cast<long double>(value), 1.0L / k);
+    x = aint::from_dblock(static_cast<dblock_t>(estimate) + 1);
+    while (power(x, k) <= a) {
+      x += 1u;
+    }
+  } else if (shift == 0) {
+    x = aint(1u) << ((bits + k - 1) / k);
+  } else {
+    // The root of the leading bits is the leading half of the root, one
+    // iteration doubling its precision.
+    x = (iroot(a >> (k * shift), k) + aint(1u)) << shift;
+  }
+
+  aint next;
+  while (true) {
+    next = x;
+    next *= k - 1;
+    next += a / power(x, k - 1);
+    next /= k;
+    if (next >= x) {
+      return x;
+    }
+    x = std::move(next);
+  }
+}
+
+aint isqrt(const aint &a) { return iroot(a, 2); }
+
+bool is_perfect_square(const aint &a) {
+  if (a.zero()) {
+    return true;
+  }
+  static const square_residues filters[] = {
+      square_residues(64), square_residues(63), square_residues(65),
+      square_residues(11)};
+  if (!filters[0].residue[a.blocks_[0] % 64]) {
+    return false;
+  }
+  // A single pass over the blocks gives the residue for the three odd moduli.
+  const block_t folded_modulus = 63 * 65 * 11;
+  dblock_t folded = 0;
+  for (size_t i = a.size(); i > 0; i--) {
+    folded = ((folded << BLOCK_WIDTH) | a.blocks_[i - 1]) % folded_modulus;
+  }
+  for (size_t i = 1; i < 4; i++) {
+    if (!filters[i].residue[folded % filters[i].modulus]) {
+      return false;
+    }
+  }
+  aint root = isqrt(a);
+  return square(root) == a;
+}
@@ -0,0 +1,18 @@
+#ifndef LAB_AINT_THRESHOLDS_H_
+#define LAB_AINT_THRESHOLDS_H_
+
+/**
+ * Default limb-count thresholds used to select the multiplication and
+ * division algorithms. An operation switches to the next algorithm once the
+ * smallest operand reaches the threshold.
+ *
+ * @note
+ * This file can be regenerated for the host CPU by running the aint_tune
+ * executable: `aint_tune src/aint/thresholds.hpp`.
+ */
+#define AINT_MUL_KARATSUBA_THRESHOLD 29
+#define AINT_MUL_TOOM3_THRESHOLD 117
+#define AINT_MUL_NTT_THRESHOLD 10348
+#define AINT_DIV_NEWTON_THRESHOLD 2016
+
+#endif // LAB_AINT_THRESHOLDS_H_
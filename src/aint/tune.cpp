@@ -0,0 +1,148 @@
+/**
+ * Measures the multiplication and division algorithms on the host CPU and
+ * generates the thresholds.hpp header selecting between them.
+ *
+ * Usage: aint_tune [output file]
+ * The header is printed on the standard output if no file is given. The
+ * measurements are only meaningful with an optimized build
+ * (CMAKE_BUILD_TYPE=Release).
+ */
+#include "mpn.hpp"
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+/**
+ * Minimal duration of a measurement, in seconds.
+ */
+static const double MIN_MEASURE_TIME = 0.02;
+
+static void fill_random(std::vector<block_t> &v, uint64_t &seed) {
+  for (auto &block : v) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    block = static_cast<block_t>(seed >> 11);
+  }
+}
+
+/**
+ * @return The mean time of a product of two `n` blocks numbers with the
+ * current thresholds, in seconds
+ */
+static double time_mul(size_t n) {
+  uint64_t seed = n;
+  std::vector<block_t> a(n), b(n), r(2 * n);
+  fill_random(a, seed);
+  fill_random(b, seed);
+  size_t repetitions = 0;
+  auto start = std::chrono::steady_clock::now();
+  double elapsed;
+  do {
+    mpn::mul(r.data(), a.data(), n, b.data(), n);
+    repetitions++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+  } while (elapsed < MIN_MEASURE_TIME);
+  return elapsed / repetitions;
+}
+
+/**
+ * @return The mean time of the division of a `2n` blocks number by a `n`
+ * blocks number with the current thresholds, in seconds
+ */
+static double time_div(size_t n) {
+  uint64_t seed = n;
+  std::vector<block_t> a(2 * n), d(n), q(n + 1), r(n);
+  fill_random(a, seed);
+  fill_random(d, seed);
+  d[n - 1] |= 1;
+  size_t repetitions = 0;
+  auto start = std::chrono::steady_clock::now();
+  double elapsed;
+  do {
+    mpn::divrem(q.data(), r.data(), a.data(), 2 * n, d.data(), n);
+    repetitions++;
+    elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                            start)
+                  .count();
+  } while (elapsed < MIN_MEASURE_TIME);
+  return elapsed / repetitions;
+}
+
+/**
+ * Finds the smallest size from which enabling an algorithm at the top level
+ * is faster than keeping it disabled, on two consecutive measured sizes.
+ * @param threshold The threshold of the algorithm in mpn::thresholds
+ * @param time The function measuring the operation for a given size
+ * @return The threshold, or `max` if the algorithm never won
+ */
+static size_t find_threshold(size_t &threshold, size_t min, size_t max,
+                             double (*time)(size_t) = time_mul) {
+  size_t candidate = SIZE_MAX;
+  for (size_t n = min; n <= max; n += n / 4 + 1) {
+    threshold = SIZE_MAX;
+    double disabled = time(n);
+    threshold = n;
+    double enabled = time(n);
+    std::cerr << "  " << n << ": " << disabled * 1e6 << "us -> "
+              << enabled * 1e6 << "us" << std::endl;
+    if (enabled < disabled) {
+      if (candidate != SIZE_MAX) {
+        threshold = candidate;
+        return candidate;
+      }
+      candidate = n;
+    } else {
+      candidate = SIZE_MAX;
+    }
+  }
+  threshold = max;
+  return max;
+}
+
+int main(int argc, char **argv) {
+  mpn::thresholds = {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+  std::cerr << "Karatsuba:" << std::endl;
+  size_t karatsuba = find_threshold(mpn::thresholds.mul_karatsuba, 8, 512);
+  std::cerr << "Toom-3:" << std::endl;
+  size_t toom3 = find_threshold(mpn::thresholds.mul_toom3, karatsuba, 4096);
+  std::cerr << "NTT:" << std::endl;
+  size_t ntt = find_threshold(mpn::thresholds.mul_ntt, toom3, 65536);
+  std::cerr << "Newton division:" << std::endl;
+  size_t newton =
+      find_threshold(mpn::thresholds.div_newton, 16, 16384, time_div);
+
+  std::ofstream file;
+  if (argc > 1) {
+    file.open(argv[1]);
+    if (!file) {
+      std::cerr << "Cannot open " << argv[1] << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &o = argc > 1 ? file : std::cout;
+  o << "#ifndef LAB_AINT_THRESHOLDS_H_\n"
+       "#define LAB_AINT_THRESHOLDS_H_\n"
+       "\n"
+       "/**\n"
+       " * Default limb-count thresholds used to select the multiplication "
+       "and\n"
+       " * division algorithms. An operation switches to the next algorithm "
+       "once the\n"
+       " * smallest operand reaches the threshold.\n"
+       " *\n"
+       " * @note\n"
+       " * This file can be regenerated for the host CPU by running the "
+       "aint_tune\n"
+       " * executable: `aint_tune src/aint/thresholds.hpp`.\n"
+       " */\n"
+    << "#define AINT_MUL_KARATSUBA_THRESHOLD " << karatsuba << "\n"
+    << "#define AINT_MUL_TOOM3_THRESHOLD " << toom3 << "\n"
+    << "#define AINT_MUL_NTT_THRESHOLD " << ntt << "\n"
+    << "#define AINT_DIV_NEWTON_THRESHOLD " << newton << "\n"
+    << "\n"
+       "#endif // LAB_AINT_THRESHOLDS_H_\n";
+  return 0;
+}
@@ -0,0 +1,233 @@
+#include "view.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#if AINT_HAVE_MAPPING
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Header of a serialized aint, followed by its blocks. Both fields are 64 bits
+ * wide so that the blocks stay aligned.
+ */
+struct serialized_header {
+  uint64_t block_width;
+  uint64_t size;
+};
+
+/**
+ * Number of blocks read at a time by deserialize(), so that the aint grows
+ * with the data actually read rather than with the size claimed by the header.
+ */
+static const size_t DESERIALIZE_CHUNK_BLOCKS = 1 << 16;
+
+void serialize(const aint &a, std::ostream &o) {
+  serialized_header header = {BLOCK_WIDTH, a.size()};
+  o.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  o.write(reinterpret_cast<const char *>(a.blocks_),
+          static_cast<std::streamsize>(a.size() * sizeof(block_t)));
+}
+
+aint deserialize(std::istream &i) {
+  serialized_header header;
+  if (!i.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+    throw std::invalid_argument("Truncated serialized aint");
+  }
+  if (header.block_width != BLOCK_WIDTH) {
+    throw std::invalid_argument("Serialized aint has another block width");
+  }
+  if (header.size > SIZE_MAX / sizeof(block_t)) {
+    throw std::invalid_argument("Serialized aint too large");
+  }
+  size_t size = static_cast<size_t>(header.size);
+  aint a;
+  for (size_t read = 0; read < size;) {
+    size_t count = std::min(size - read, DESERIALIZE_CHUNK_BLOCKS);
+    if (read + count > a.capacity()) {
+      // Doubles the capacity to keep the copies linear in the size.
+      a.size_ = read;
+      a.resize(std::min(size, std::max(read + count, 2 * a.capacity())));
+    }
+    if (!i.read(reinterpret_cast<char *>(a.blocks_ + read),
+                static_cast<std::streamsize>(count * sizeof(block_t)))) {
+      throw std::invalid_argument("Truncated serialized aint");
+    }
+    read += count;
+  }
+  a.size_ = size;
+  a.refresh_size();
+  return a;
+}
+
+void aint_view::borrow(const block_t *blocks, size_t n) noexcept {
+  // The blocks are never written through a constant aint.
+  this->value_.blocks_ = n == 0 ? this->value_.inline_blocks_
+                                 : const_cast<block_t *>(blocks);
+  this->value_.capacity_ = n;
+  this->value_.size_ = n;
+  this->value_.refresh_size();
+}
+
+aint_view::aint_view() noexcept {}
+
+aint_view::aint_view(const block_t *blocks, size_t n) noexcept {
+  this->borrow(blocks, n);
+}
+
+aint_view::aint_view(const aint &a) noexcept {
+  this->borrow(a.blocks_, a.size());
+}
+
+aint_view::aint_view(const aint_view &other) noexcept {
+  this->borrow(other.data(), other.size());
+}
+
+aint_view &aint_view::operator=(const aint_view &other) noexcept {
+  this->borrow(other.data(), other.size());
+  return *this;
+}
+
+aint_view::~aint_view() {
+  // Gives the aint back its own empty storage so that it frees nothing.
+  this->value_.blocks_ = this->value_.inline_blocks_;
+  this->value_.capacity_ = 0;
+  this->value_.size_ = 0;
+}
+
+aint_view::operator const aint &() const noexcept { return this->value_; }
+
+const aint &aint_view::value() const noexcept { return this->value_; }
+
+const block_t *aint_view::data() const noexcept {
+  return this->value_.blocks_;
+}
+
+size_t aint_view::size() const noexcept { return this->value_.size(); }
+
+bool aint_view::operator<(const aint &other) const {
+  return this->value_ < other;
+}
+
+bool aint_view::operator>(const aint &other) const {
+  return this->value_ > other;
+}
+
+bool aint_view::operator<=(const aint &other) const {
+  return this->value_ <= other;
+}
+
+bool aint_view::operator>=(const aint &other) const {
+  return this->value_ >= other;
+}
+
+bool aint_view::operator==(const aint &other) const {
+  return this->value_ == other;
+}
+
+bool aint_view::operator!=(const aint &other) const {
+  return this->value_ != other;
+}
+
+aint aint_view::operator+(const aint &other) const {
+  return this->value_ + other;
+}
+
+aint aint_view::operator-(const aint &other) const {
+  return this->value_ - other;
+}
+
+aint aint_view::operator*(const aint &other) const {
+  return this->value_ * other;
+}
+
+aint aint_view::operator/(const aint &other) const {
+  return this->value_ / other;
+}
+
+aint aint_view::operator%(const aint &other) const {
+  return this->value_ % other;
+}
+
+aint aint_view::operator<<(size_t offset) const {
+  return this->value_ << offset;
+}
+
+aint aint_view::operator>>(size_t offset) const {
+  return this->value_ >> offset;
+}
+
+aint aint_view::operator&(const aint &other) const {
+  return this->value_ & other;
+}
+
+aint aint_view::operator|(const aint &other) const {
+  return this->value_ | other;
+}
+
+aint aint_view::operator^(const aint &other) const {
+  return this->value_ ^ other;
+}
+
+aint aint_view::operator~() const { return ~this->value_; }
+
+aint_view deserialize_view(const void *data, size_t length) {
+  if (reinterpret_cast<uintptr_t>(data) % alignof(uint64_t) != 0) {
+    throw std::invalid_argument("Misaligned serialized aint");
+  }
+  serialized_header header;
+  if (length < sizeof(header)) {
+    throw std::invalid_argument("Truncated serialized aint");
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (header.block_width != BLOCK_WIDTH) {
+    throw std::invalid_argument("Serialized aint has another block width");
+  }
+  if (header.size > (length - sizeof(header)) / sizeof(block_t)) {
+    throw std::invalid_argument("Truncated serialized aint");
+  }
+  return aint_view(reinterpret_cast<const block_t *>(
+                       static_cast<const char *>(data) + sizeof(header)),
+                   header.size);
+}
+
+#if AINT_HAVE_MAPPING
+aint_mapping::aint_mapping(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), path);
+  }
+  struct stat status;
+  if (fstat(fd, &status) < 0) {
+    int error = errno;
+    close(fd);
+    throw std::system_error(error, std::generic_category(), path);
+  }
+  this->length_ = static_cast<size_t>(status.st_size);
+  this->data_ = nullptr;
+  if (this->length_ != 0) {
+    this->data_ =
+        mmap(nullptr, this->length_, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  int error = errno;
+  close(fd);
+  if (this->data_ == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), path);
+  }
+}
+
+aint_mapping::~aint_mapping() {
+  if (this->data_ != nullptr) {
+    munmap(this->data_, this->length_);
+  }
+}
+
+aint_view aint_mapping::view() const {
+  return deserialize_view(this->data_, this->length_);
+}
+#endif
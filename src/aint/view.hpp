@@ -0,0 +1,129 @@
+#ifndef LAB_AINT_VIEW_H_
+#define LAB_AINT_VIEW_H_
+#include "aint.hpp"
+
+/**
+ * Read-only aint over blocks it does not own, such as a little-endian array of
+ * blocks read from a file or a shared-memory segment.
+ *
+ * @details
+ * The view converts to `const aint &` without copying any block, so it is
+ * accepted by every operation taking a constant aint: comparisons, arithmetic
+ * and bitwise operators, gcd(), divmod(), ... Copying a view into an aint
+ * copies the blocks.
+ *
+ * @note
+ * The blocks must outlive the view and all the views copied from it, and must
+ * not be modified while they are viewed.
+ */
+class aint_view {
+  /**
+   * Aint borrowing the blocks, its capacity being their number.
+   */
+  aint value_;
+
+  /**
+   * Makes aint_view::value_ borrow `n` blocks.
+   */
+  void borrow(const block_t *blocks, size_t n) noexcept;
+
+public:
+  /**
+   * Views the zero aint.
+   */
+  aint_view() noexcept;
+  /**
+   * @param blocks The blocks, least significant first
+   * @param n The number of blocks, which may include trailing zero blocks
+   */
+  aint_view(const block_t *blocks, size_t n) noexcept;
+  /**
+   * Views the blocks of an aint, which must not be modified during the
+   * lifetime of the view.
+   */
+  explicit aint_view(const aint &a) noexcept;
+  aint_view(const aint_view &other) noexcept;
+  aint_view &operator=(const aint_view &other) noexcept;
+  ~aint_view();
+
+  operator const aint &() const noexcept;
+  /**
+   * @return The viewed value
+   */
+  const aint &value() const noexcept;
+  /**
+   * @return The viewed blocks
+   */
+  const block_t *data() const noexcept;
+  /**
+   * @return The number of blocks of the viewed value, excluding the trailing
+   * zero blocks.
+   */
+  size_t size() const noexcept;
+
+  bool operator<(const aint &other) const;
+  bool operator>(const aint &other) const;
+  bool operator<=(const aint &other) const;
+  bool operator>=(const aint &other) const;
+  bool operator==(const aint &other) const;
+  bool operator!=(const aint &other) const;
+
+  aint operator+(const aint &other) const;
+  aint operator-(const aint &other) const;
+  aint operator*(const aint &other) const;
+  aint operator/(const aint &other) const;
+  aint operator%(const aint &other) const;
+  aint operator<<(size_t offset) const;
+  aint operator>>(size_t offset) const;
+  aint operator&(const aint &other) const;
+  aint operator|(const aint &other) const;
+  aint operator^(const aint &other) const;
+  aint operator~() const;
+};
+
+/**
+ * Views an aint serialized by serialize(const aint &, std::ostream &), for
+ * instance in a mapped file, without copying its blocks.
+ * @param data The serialized aint, aligned for block_t
+ * @param length The number of bytes available at `data`
+ * @throw std::invalid_argument Thrown if the data is misaligned, truncated or
+ * was written with another block width
+ */
+aint_view deserialize_view(const void *data, size_t length);
+
+#if defined(__unix__) || defined(__APPLE__)
+#define AINT_HAVE_MAPPING 1
+#else
+#define AINT_HAVE_MAPPING 0
+#endif
+
+#if AINT_HAVE_MAPPING
+/**
+ * Read-only memory mapping of a file containing a serialized aint, available
+ * on POSIX systems only (AINT_HAVE_MAPPING).
+ * @see deserialize_view(const void *, size_t)
+ */
+class aint_mapping {
+  void *data_;
+  size_t length_;
+
+public:
+  /**
+   * @param path The path of the file
+   * @throw std::system_error Thrown if the file cannot be mapped
+   */
+  explicit aint_mapping(const char *path);
+  ~aint_mapping();
+  aint_mapping(const aint_mapping &) = delete;
+  aint_mapping &operator=(const aint_mapping &) = delete;
+
+  /**
+   * @return A view of the aint stored in the file, valid as long as the
+   * mapping
+   * @throw std::invalid_argument Thrown if the file is not a serialized aint
+   */
+  aint_view view() const;
+};
+#endif
+
+#endif // LAB_AINT_VIEW_H_
@@ -1,6 +1,36 @@
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
 #include "../src/aint/aint.hpp"
+#include "../src/aint/arena.hpp"
+#include "../src/aint/batch.hpp"
+#include "../src/aint/faint.hpp"
+#include "../src/aint/literal.hpp"
+#include "../src/aint/montgomery.hpp"
+#include "../src/aint/mpn.hpp"
+#include "../src/aint/view.hpp"
+
+/**
+ * Builds a pseudo-random aint of `size` blocks with a non-zero most significant
+ * block.
+ */
+static aint random_aint(size_t size, uint32_t seed) {
+  aint a;
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1664525u + 1013904223u;
+    a <<= BLOCK_WIDTH;
+    a += aint(seed | (i == 0 ? 1u : 0u));
+  }
+  return a;
+}
 
 TEST(AInt, Argument_less_construction) {
   aint a;
@@ -31,13 +61,89 @@ TEST(AInt, String_construction) {
 
   aint d =
           const_cast<char*>("000000000000000000000000000000001000000000000000000000000000000001000000000000000000000000000000");
+#if AINT_BLOCK_WIDTH == 32
   ASSERT_EQ(d.size(), 3);
   ASSERT_EQ(d.get_blocks()[0], 0u);
   ASSERT_EQ(d.get_blocks()[1], 1u);
   ASSERT_EQ(d.get_blocks()[2], 2u);
+#else
+  ASSERT_EQ(d.size(), 2);
+  ASSERT_EQ(d.get_blocks()[0], static_cast<block_t>(1) << 32);
+  ASSERT_EQ(d.get_blocks()[1], 2u);
+#endif
 
   ASSERT_THROW(aint(const_cast<char*>("0a")), std::invalid_argument);
 }
+/**
+ * @return The rendering of an aint in the given base, as a std::string
+ */
+static std::string render(const aint &a, unsigned base) {
+  char *str = a.to_string(base);
+  std::string result = str;
+  free(str);
+  return result;
+}
+
+TEST(AInt, String_conversion) {
+  ASSERT_EQ(render(aint(), 10), "0");
+  ASSERT_EQ(render(aint(), 16), "0");
+  ASSERT_TRUE(aint::from_string("", 10).zero());
+  ASSERT_EQ(aint::from_string("0042", 10), aint(42u));
+  ASSERT_EQ(aint::from_string("DEADbeef", 16), aint(0xdeadbeefu));
+  ASSERT_EQ(aint::from_string("01", 2), aint(2u));
+  ASSERT_EQ(render(aint(255u), 16), "ff");
+  ASSERT_EQ(render(aint(2u), 2), "01");
+
+  const char *two_pow_100 = "1267650600228229401496703205376";
+  ASSERT_EQ(aint::from_string(two_pow_100, 10), aint(1u) << 100);
+  ASSERT_EQ(render(aint(1u) << 100, 10), two_pow_100);
+  ASSERT_EQ(render(aint(1u) << 100, 16), "1" + std::string(25, '0'));
+
+  // Large enough to go through the divide-and-conquer conversions.
+  std::string power_of_ten = "1" + std::string(5000, '0');
+  aint a = aint::from_string(power_of_ten.c_str(), 10);
+  ASSERT_EQ(render(a, 10), power_of_ten);
+  aint ten = aint(10u), expected = aint(1u);
+  for (int i = 0; i < 5000; i++) {
+    expected *= ten;
+  }
+  ASSERT_EQ(a, expected);
+  aint b = random_aint(3000, 8);
+  ASSERT_EQ(aint::from_string(render(b, 10).c_str(), 10), b);
+  ASSERT_EQ(aint::from_string(render(b, 16).c_str(), 16), b);
+  ASSERT_EQ(aint::from_string(render(b, 2).c_str(), 2), b);
+  std::string upper = render(b, 16);
+  std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+  ASSERT_EQ(aint::from_string(upper.c_str(), 16), b);
+
+  ASSERT_THROW(aint::from_string("12a", 10), std::invalid_argument);
+  ASSERT_THROW(aint::from_string("12", 8), std::invalid_argument);
+  ASSERT_THROW(aint(1u).to_string(8), std::invalid_argument);
+}
+TEST(AInt, Stream_extraction) {
+  std::istringstream input("0 1 1\n101\n01x1\n1");
+  aint a;
+  ASSERT_TRUE(input >> a);
+  ASSERT_EQ(a, aint(6u));
+  ASSERT_TRUE(input >> a);
+  ASSERT_EQ(a, aint(5u));
+  ASSERT_FALSE(input >> a);
+  ASSERT_TRUE(a.zero());
+  input.clear();
+  ASSERT_TRUE(input >> a);
+  ASSERT_EQ(a, aint(1u));
+  ASSERT_TRUE(input.eof());
+
+  // Longer than the chunks pulled from the stream, with spaces in between.
+  aint b = random_aint(10000, 9);
+  std::string line = render(b, 2);
+  line.insert(100, "  ");
+  std::istringstream long_input(line + "\n" + line);
+  ASSERT_TRUE(long_input >> a);
+  ASSERT_EQ(a, b);
+  ASSERT_TRUE(long_input >> a);
+  ASSERT_EQ(a, b);
+}
 TEST(AInt, Copy) {
   aint a = aint(2u);
   aint b = aint(a);
@@ -72,6 +178,109 @@ TEST(AInt, Memory_management) {
   ASSERT_EQ(b.get_blocks()[0], 1u);
 }
 
+/**
+ * @return True if the blocks of `a` are stored inside the object
+ */
+static bool stored_inline(aint &a) {
+  auto blocks = reinterpret_cast<const char *>(a.get_blocks());
+  auto object = reinterpret_cast<const char *>(&a);
+  return blocks >= object && blocks < object + sizeof(aint);
+}
+TEST(AInt, Small_buffer) {
+  aint a = 1u;
+  ASSERT_TRUE(stored_inline(a));
+  aint big = random_aint(AINT_INLINE_CAPACITY + 1, 8);
+  ASSERT_FALSE(stored_inline(big));
+
+  // Copy and move between inline and heap storage.
+  aint b = big;
+  aint c = a;
+  ASSERT_TRUE(stored_inline(c));
+  ASSERT_EQ(c, a);
+  c = std::move(b);
+  ASSERT_FALSE(stored_inline(c));
+  ASSERT_EQ(c, big);
+  ASSERT_TRUE(b.zero());
+  b = std::move(a);
+  ASSERT_TRUE(stored_inline(b));
+  ASSERT_EQ(b, 1u);
+  ASSERT_TRUE(a.zero());
+
+  b.swap(c);
+  ASSERT_EQ(b, big);
+  ASSERT_EQ(c, 1u);
+  ASSERT_FALSE(stored_inline(b));
+  ASSERT_TRUE(stored_inline(c));
+
+  // Shrinking moves the blocks back into the object.
+  b >>= BLOCK_WIDTH * 2;
+  b.shrink_to_fit();
+  ASSERT_TRUE(stored_inline(b));
+  ASSERT_EQ(b, big >> BLOCK_WIDTH * 2);
+  b.reserve(AINT_INLINE_CAPACITY * 4);
+  ASSERT_FALSE(stored_inline(b));
+  ASSERT_EQ(b, big >> BLOCK_WIDTH * 2);
+}
+
+/**
+ * Resource counting the blocks allocated from the heap.
+ */
+class counting_resource : public std::pmr::memory_resource {
+public:
+  size_t allocated = 0;
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    this->allocated += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    this->allocated -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+TEST(AInt, Memory_resource) {
+  counting_resource counting;
+  aint big = random_aint(100, 10);
+  {
+    aint a(&counting);
+    a = big;
+    ASSERT_EQ(a.resource(), &counting);
+    ASSERT_GE(counting.allocated, 100 * sizeof(block_t));
+    a.resize(200);
+    ASSERT_EQ(a, big);
+    // Moving between resources copies the blocks.
+    aint b = std::move(a);
+    ASSERT_EQ(b.resource(), &counting);
+    aint c;
+    c = std::move(b);
+    ASSERT_EQ(c.resource(), nullptr);
+    ASSERT_EQ(c, big);
+    ASSERT_EQ(b, big);
+    b.swap(c);
+    ASSERT_EQ(b.resource(), nullptr);
+    ASSERT_EQ(c.resource(), &counting);
+  }
+  ASSERT_EQ(counting.allocated, 0u);
+
+  aint result, expected = big * big + big;
+  {
+    aint_arena arena;
+    ASSERT_EQ(aint::default_resource(), arena.resource());
+    aint x = big;
+    aint y = x * x + x;
+    ASSERT_EQ(y.resource(), arena.resource());
+    result = std::move(y);
+  }
+  ASSERT_EQ(aint::default_resource(), nullptr);
+  ASSERT_EQ(result.resource(), nullptr);
+  ASSERT_EQ(result, expected);
+}
 TEST(AInt, Comparison_one_block) {
   aint a = 1u;
   aint b = 2u;
@@ -115,6 +324,22 @@ TEST(AInt, Operation_add) {
   c = a + b;
   ASSERT_EQ(c, aint(const_cast<char*>("000000000000000000000000000000001")));
 }
+TEST(AInt, Operation_add_subtract_carry_chain) {
+  aint one = 1u;
+  aint m = (one << 1000) - one;
+  // The carry runs through every block of the longest operand.
+  ASSERT_EQ(m + one, one << 1000);
+  ASSERT_EQ(one + m, one << 1000);
+  aint c = one;
+  c += m;
+  ASSERT_EQ(c, one << 1000);
+  ASSERT_EQ(c - one, m);
+  c -= one;
+  ASSERT_EQ(c, m);
+  c += c;
+  ASSERT_EQ(c, (one << 1001) - (one << 1));
+  ASSERT_THROW(one - m, std::invalid_argument);
+}
 TEST(AInt, Operation_subtract) {
   aint a = 3u;
   aint b = 1u;
@@ -150,6 +375,200 @@ TEST(AInt, Operation_multiply) {
   ASSERT_EQ(c,
           aint(const_cast<char*>("01100000000000000000000000000000111000000000000000000000000000001")));
 }
+TEST(AInt, Operation_multiply_large) {
+  mpn::thresholds_t defaults = mpn::thresholds;
+  aint a = random_aint(300, 1);
+  aint b = random_aint(200, 2);
+  aint c = random_aint(40, 3);
+  mpn::thresholds = {SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+  aint ab = a * b, ac = a * c, bb = b * b;
+  // Karatsuba only, then Karatsuba and Toom-3, then NTT only.
+  mpn::thresholds = {8, SIZE_MAX, SIZE_MAX, SIZE_MAX};
+  ASSERT_EQ(a * b, ab);
+  ASSERT_EQ(c * a, ac);
+  ASSERT_EQ(b * b, bb);
+  mpn::thresholds = {8, 16, SIZE_MAX, SIZE_MAX};
+  ASSERT_EQ(a * b, ab);
+  ASSERT_EQ(c * a, ac);
+  ASSERT_EQ(b * b, bb);
+  mpn::thresholds = {SIZE_MAX, SIZE_MAX, 1, SIZE_MAX};
+  ASSERT_EQ(a * b, ab);
+  ASSERT_EQ(c * a, ac);
+  ASSERT_EQ(b * b, bb);
+  mpn::thresholds = defaults;
+
+  // (2^n - 1)^2 = 2^2n - 2^(n+1) + 1
+  aint one = 1u;
+  aint m = (one << 9000) - one;
+  ASSERT_EQ(m * m, (one << 18000) - (one << 9001) + one);
+}
+TEST(AInt, Operation_multiply_parallel) {
+  mpn::thresholds_t defaults = mpn::thresholds;
+  aint a = random_aint(900, 14);
+  aint b = random_aint(700, 15);
+  aint ab = a * b, aa = a * a;
+  // Karatsuba only, then Karatsuba and Toom-3, then NTT only.
+  mpn::thresholds_t variants[] = {{8, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+                                  {8, 16, SIZE_MAX, SIZE_MAX},
+                                  {SIZE_MAX, SIZE_MAX, 1, SIZE_MAX}};
+  mpn::parallel = {4, 16};
+  for (auto &variant : variants) {
+    mpn::thresholds = variant;
+    ASSERT_EQ(a * b, ab);
+    ASSERT_EQ(square(a), aa);
+  }
+  mpn::thresholds = defaults;
+  mpn::parallel = {1, 1024};
+  ASSERT_EQ(a * b, ab);
+}
+TEST(AInt, Operation_square) {
+  mpn::thresholds_t defaults = mpn::thresholds;
+  ASSERT_TRUE(square(aint()).zero());
+  ASSERT_EQ(square(aint(BLOCK_MAX)), aint(BLOCK_MAX) * aint(BLOCK_MAX));
+  // Basecase, Karatsuba only, Karatsuba and Toom-3, then NTT only.
+  mpn::thresholds_t variants[] = {{SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+                                  {8, SIZE_MAX, SIZE_MAX, SIZE_MAX},
+                                  {8, 16, SIZE_MAX, SIZE_MAX},
+                                  {SIZE_MAX, SIZE_MAX, 1, SIZE_MAX}};
+  for (size_t size : {1, 2, 7, 50, 301}) {
+    aint a = random_aint(size, static_cast<uint32_t>(size));
+    aint copy = a;
+    mpn::thresholds = defaults;
+    aint expected = a * copy;
+    for (auto &variant : variants) {
+      mpn::thresholds = variant;
+      ASSERT_EQ(square(a), expected);
+      ASSERT_EQ(a * a, expected);
+      aint b = a;
+      b *= b;
+      ASSERT_EQ(b, expected);
+    }
+  }
+  mpn::thresholds = defaults;
+}
+TEST(AInt, Operation_rvalue) {
+  aint a = random_aint(40, 23), b = random_aint(30, 24);
+  aint sum = a + b, difference = a - b;
+
+  aint c = a;
+  const block_t *blocks = c.get_blocks();
+  aint d = std::move(c) + b;
+  ASSERT_EQ(d, sum);
+  ASSERT_EQ(d.get_blocks(), blocks);
+  // The temporary keeps its blocks as long as they are enough.
+  c = b;
+  c.reserve(a.size() + 1);
+  blocks = c.get_blocks();
+  d = a + std::move(c);
+  ASSERT_EQ(d, sum);
+  ASSERT_EQ(d.get_blocks(), blocks);
+  c = b;
+  c.reserve(a.size());
+  blocks = c.get_blocks();
+  d = a - std::move(c);
+  ASSERT_EQ(d, difference);
+  ASSERT_EQ(d.get_blocks(), blocks);
+  c = a;
+  c.reserve(a.size() + 1);
+  blocks = c.get_blocks();
+  d = (std::move(c) << 3 ^ b) >> 3;
+  ASSERT_EQ(d, ((a << 3) ^ b) >> 3);
+  ASSERT_EQ(d.get_blocks(), blocks);
+
+  ASSERT_EQ(aint(a) + aint(b), sum);
+  ASSERT_EQ(aint(a) - aint(b), difference);
+  ASSERT_EQ(aint(a) * aint(b), a * b);
+  ASSERT_EQ(aint(a) / b, a / b);
+  ASSERT_EQ(aint(a) % b, a % b);
+  ASSERT_EQ(aint(a) & aint(b), a & b);
+  ASSERT_EQ(a | aint(b), a | b);
+  ASSERT_EQ(~aint(a), ~a);
+  ASSERT_THROW(b - aint(a), std::invalid_argument);
+  aint e = a;
+  ASSERT_TRUE((e - std::move(e)).zero());
+
+  // Copies are sized to the value.
+  aint big = random_aint(50, 25);
+  big.reserve(1000);
+  aint copy = big;
+  ASSERT_EQ(copy.capacity(), big.size());
+  copy = b;
+  ASSERT_EQ(copy, b);
+  ASSERT_EQ(copy.capacity(), big.size());
+  ASSERT_EQ(copy + aint(1u), b + aint(1u));
+}
+TEST(AInt, Operation_fused_multiply_add) {
+  aint a = random_aint(12, 4), b = random_aint(5, 5), c = random_aint(60, 6);
+  aint r = random_aint(30, 7), expected = r + a * b;
+  addmul(r, a, b);
+  ASSERT_EQ(r, expected);
+  submul(r, b, a);
+  ASSERT_EQ(r, expected - a * b);
+  expected = r + ((c * c) << 77);
+  mul_add_shifted(r, c, c, 77);
+  ASSERT_EQ(r, expected);
+  expected = r + ((a * b) << (3 * BLOCK_WIDTH));
+  mul_add_shifted(r, a, b, 3 * BLOCK_WIDTH);
+  ASSERT_EQ(r, expected);
+
+  // Aliased accumulator, empty accumulator.
+  expected = r + r * a;
+  addmul(r, r, a);
+  ASSERT_EQ(r, expected);
+  submul(r, r, aint(1u));
+  ASSERT_TRUE(r.zero());
+  addmul(r, b, a);
+  ASSERT_EQ(r, a * b);
+
+  // The accumulator is left unchanged when the product is higher.
+  r = a * b - aint(1u);
+  aint before = r;
+  ASSERT_THROW(submul(r, a, b), std::invalid_argument);
+  ASSERT_EQ(r, before);
+  ASSERT_THROW(submul(r, c, b), std::invalid_argument);
+  ASSERT_EQ(r, before);
+}
+TEST(AInt, Operation_block) {
+  aint a = random_aint(20, 16);
+  aint b = a;
+  b *= 10u;
+  ASSERT_EQ(b, a * aint(10u));
+  b /= 10u;
+  ASSERT_EQ(b, a);
+  b %= 7u;
+  ASSERT_EQ(b, a % aint(7u));
+  b = a;
+  b += BLOCK_MAX;
+  ASSERT_EQ(b, a + aint(BLOCK_MAX));
+  b -= BLOCK_MAX;
+  ASSERT_EQ(b, a);
+  b *= 0u;
+  ASSERT_TRUE(b.zero());
+
+  // Carries and borrows through every block.
+  aint one = 1u, m = (one << (4 * BLOCK_WIDTH)) - one;
+  b = m;
+  b += 1u;
+  ASSERT_EQ(b, one << (4 * BLOCK_WIDTH));
+  b -= 1u;
+  ASSERT_EQ(b, m);
+  b *= BLOCK_MAX;
+  ASSERT_EQ(b, m * aint(BLOCK_MAX));
+  b = aint();
+  b += 3u;
+  ASSERT_EQ(b, aint(3u));
+  b %= 3u;
+  ASSERT_TRUE(b.zero());
+  b /= 3u;
+  ASSERT_TRUE(b.zero());
+
+  ASSERT_THROW(b -= 1u, std::invalid_argument);
+  b = 2u;
+  ASSERT_THROW(b -= 3u, std::invalid_argument);
+  ASSERT_THROW(b /= 0u, std::invalid_argument);
+  ASSERT_THROW(b %= 0u, std::invalid_argument);
+  ASSERT_EQ(b, aint(2u));
+}
 TEST(AInt, Operation_divide) {
   aint a, b, c;
   a = const_cast<char*>("01");
@@ -180,6 +599,490 @@ TEST(AInt, Operation_modulo) {
   c = a % b;
   ASSERT_EQ(c, aint(const_cast<char*>("000000000000000000000000000001")));
 }
+TEST(AInt, Operation_divmod) {
+  aint a = random_aint(120, 4);
+  aint b = random_aint(45, 5);
+  aint q, r;
+  divmod(a, b, q, r);
+  ASSERT_LT(r, b);
+  ASSERT_EQ(q * b + r, a);
+  ASSERT_EQ(a / b, q);
+  ASSERT_EQ(a % b, r);
+
+  // All-ones divisors trigger the quotient correction steps.
+  aint one = 1u;
+  aint m = (one << 2000) - one;
+  aint d = (one << 1000) - one;
+  divmod(m, d, q, r);
+  ASSERT_EQ(q, (one << 1000) + one);
+  ASSERT_TRUE(r.zero());
+
+  // The results may alias the operands.
+  aint c = a;
+  divmod(c, b, c, r);
+  ASSERT_EQ(c, q = a / b);
+  c = a;
+  divmod(c, b, q, c);
+  ASSERT_EQ(c, a % b);
+
+  // Division by Newton reciprocal.
+  mpn::thresholds_t defaults = mpn::thresholds;
+  aint e = random_aint(400, 6);
+  aint f = random_aint(150, 7);
+  aint ef_q, ef_r;
+  mpn::thresholds.div_newton = SIZE_MAX;
+  divmod(e, f, ef_q, ef_r);
+  mpn::thresholds.div_newton = 8;
+  divmod(e, f, q, r);
+  ASSERT_EQ(q, ef_q);
+  ASSERT_EQ(r, ef_r);
+  divmod(m, d, q, r);
+  ASSERT_EQ(q, (one << 1000) + one);
+  ASSERT_TRUE(r.zero());
+  mpn::thresholds = defaults;
+
+  aint zero;
+  ASSERT_TRUE((zero % b).zero());
+  ASSERT_THROW(divmod(a, zero, q, r), std::invalid_argument);
+}
+/**
+ * @return base^exponent % modulus by square-and-multiply
+ */
+static aint naive_powmod(const aint &base, aint exponent,
+                         const aint &modulus) {
+  aint result = aint(1u) % modulus, power = base % modulus;
+  for (; !exponent.zero(); exponent >>= 1) {
+    if (exponent.get_blocks()[0] & 1) {
+      result = result * power % modulus;
+    }
+    power = power * power % modulus;
+  }
+  return result;
+}
+
+TEST(AInt, Mpn_scratch) {
+  aint a = random_aint(120, 21), b = random_aint(70, 22);
+  size_t an = a.size(), bn = b.size();
+  // Every buffer is allocated once for the whole loop.
+  std::vector<block_t> product(an + bn), square(2 * an), q(an - bn + 1),
+      r(bn),
+      scratch(std::max({mpn::mul_itch(an, bn), mpn::sqr_itch(an),
+                        mpn::divrem_itch(an, bn)}));
+  for (size_t i = 0; i < 3; i++) {
+    mpn::mul(product.data(), a.get_blocks(), an, b.get_blocks(), bn,
+             scratch.data());
+    ASSERT_EQ(aint_view(product.data(), product.size()), a * b);
+    mpn::sqr(square.data(), a.get_blocks(), an, scratch.data());
+    ASSERT_EQ(aint_view(square.data(), square.size()), a * a);
+    mpn::divrem(q.data(), r.data(), a.get_blocks(), an, b.get_blocks(), bn,
+                scratch.data());
+    ASSERT_EQ(aint_view(q.data(), q.size()), a / b);
+    ASSERT_EQ(aint_view(r.data(), r.size()), a % b);
+    a += 1u;
+  }
+  ASSERT_EQ(mpn::mul_itch(an, 1), 0u);
+}
+/**
+ * Resource flagging the calls made while another one is in progress, which
+ * must not happen with a resource that is not thread-safe.
+ */
+class exclusive_resource : public std::pmr::memory_resource {
+  std::atomic<int> active_{0};
+
+  void enter() {
+    if (this->active_.fetch_add(1) != 0) {
+      this->overlapped = true;
+    }
+    // Leaves time to other threads to overlap.
+    std::this_thread::yield();
+  }
+  void leave() { this->active_.fetch_sub(1); }
+
+public:
+  std::atomic<bool> overlapped{false};
+  std::atomic<size_t> allocated{0};
+
+protected:
+  void *do_allocate(size_t bytes, size_t alignment) override {
+    this->enter();
+    void *p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    this->allocated += bytes;
+    this->leave();
+    return p;
+  }
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override {
+    this->enter();
+    this->allocated -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    this->leave();
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override {
+    return this == &other;
+  }
+};
+
+TEST(AInt, Product) {
+  std::vector<aint> factors;
+  aint expected = 1u;
+  for (uint32_t seed = 0; seed < 37; seed++) {
+    factors.push_back(random_aint(seed % 5 + 1, seed));
+    expected *= factors.back();
+  }
+  ASSERT_EQ(aint::product(factors.begin(), factors.end()), expected);
+  ASSERT_EQ(aint::product(factors.begin(), factors.begin()), aint(1u));
+
+  aint fold = 1u;
+  for (block_t i = 2; i <= 3000; i++) {
+    fold *= i;
+    if (i == 20) {
+      ASSERT_EQ(factorial(i), aint::from_string("2432902008176640000", 10));
+    }
+  }
+  ASSERT_EQ(factorial(0), aint(1u));
+  ASSERT_EQ(factorial(1), aint(1u));
+  ASSERT_EQ(factorial(3000), fold);
+
+  ASSERT_EQ(binomial(100, 50),
+            aint::from_string("100891344545564193334812497256", 10));
+  ASSERT_EQ(binomial(3000, 1200),
+            factorial(3000) / (factorial(1200) * factorial(1800)));
+  ASSERT_EQ(binomial(1000000, 3), aint::from_string("166666166667000000", 10));
+  // Large n and small k, without sieving the primes up to n.
+  ASSERT_EQ(binomial(100000000, 40),
+            aint::from_string("122560787934838513403520973457102682982810544750587912182984520719564180442550921510497415251670167968545283193363543903561981627957390574700399882351387532377847179641128786627950800316886440595569398966796784507540304609144548015089211941827349288030290368795937497500000",
+                              10));
+  ASSERT_EQ(binomial(4294967295u, 33),
+            aint::from_string("88917998314888608406072913088004797544333196491422705583406146397316174134194204233425017553684438707374081415240443534759308144057691393296531520714172428848050236190577787361399102170064232568577962499845039743694492809689821631378744220108181601053352290135222011460786948407295",
+                              10));
+  // Both paths of binomial(), C(n, k + 1) = C(n, k) (n - k) / (k + 1).
+  ASSERT_EQ(binomial(20000, 1250) * aint(1250u),
+            binomial(20000, 1249) * aint(18751u));
+  ASSERT_EQ(binomial(5, 0), aint(1u));
+  ASSERT_TRUE(binomial(5, 6).zero());
+  ASSERT_EQ(primorial(30), aint::from_string("6469693230", 10));
+  ASSERT_EQ(primorial(1), aint(1u));
+
+  mpn::parallel_t defaults = mpn::parallel;
+  mpn::parallel = {4, 16};
+  ASSERT_EQ(factorial(3000), fold);
+  ASSERT_EQ(aint::product(factors.begin(), factors.end()), expected);
+  aint large = factorial(20000);
+  exclusive_resource exclusive;
+  {
+    aint_resource_scope scope(&exclusive);
+    aint product = factorial(20000);
+    ASSERT_EQ(product.resource(), &exclusive);
+    ASSERT_EQ(product, large);
+  }
+  ASSERT_FALSE(exclusive.overlapped);
+  ASSERT_EQ(exclusive.allocated, 0u);
+  mpn::parallel = defaults;
+}
+TEST(AInt, Montgomery_powmod) {
+  aint modulus = random_aint(2048 / BLOCK_WIDTH, 11);
+  modulus += aint(1u) - modulus % aint(2u);
+  montgomery_ctx ctx(modulus);
+  ASSERT_EQ(ctx.size(), modulus.size());
+  aint base = random_aint(2112 / BLOCK_WIDTH, 12);
+  aint exponent = random_aint(2048 / BLOCK_WIDTH, 13);
+  ASSERT_EQ(ctx.powmod(base, exponent), naive_powmod(base, exponent, modulus));
+  ASSERT_EQ(ctx.powmod(base, aint(5u)), naive_powmod(base, aint(5u), modulus));
+  ASSERT_EQ(ctx.powmod(base, aint()), aint(1u));
+
+  aint a = ctx.to_montgomery(base), b = ctx.to_montgomery(exponent);
+  ASSERT_EQ(ctx.from_montgomery(a), base % modulus);
+  ctx.mulmod(a, a, b);
+  ASSERT_EQ(ctx.from_montgomery(a), base * exponent % modulus);
+  ctx.sqrmod(b, b);
+  ASSERT_EQ(ctx.from_montgomery(b), exponent * exponent % modulus);
+
+  montgomery_ctx small(aint(1000003u));
+  ASSERT_EQ(small.powmod(aint(2u), aint(1000002u)), aint(1u));
+  montgomery_ctx one(aint(1u));
+  ASSERT_TRUE(one.powmod(aint(7u), aint(3u)).zero());
+  ASSERT_THROW(montgomery_ctx(aint(10u)), std::invalid_argument);
+  ASSERT_THROW(montgomery_ctx(aint(0u)), std::invalid_argument);
+}
+TEST(AInt, Gcd) {
+  ASSERT_TRUE(gcd(aint(), aint()).zero());
+  ASSERT_EQ(gcd(aint(12u), aint()), aint(12u));
+  ASSERT_EQ(gcd(aint(), aint(12u)), aint(12u));
+  ASSERT_EQ(gcd(aint(12u), aint(18u)), aint(6u));
+  aint one = 1u;
+  ASSERT_EQ(gcd((one << 300) - one, (one << 200) - one), (one << 100) - one);
+
+  for (size_t size : {1, 3, 40, 150}) {
+    aint g = random_aint(size / 2 + 1, static_cast<uint32_t>(size));
+    aint a = random_aint(size, 20) * g, b = random_aint(size + 2, 21) * g;
+    aint expected = g * gcd(a / g, b / g);
+    ASSERT_EQ(gcd(a, b), expected);
+    ASSERT_EQ(gcd(b, a), expected);
+    ASSERT_TRUE((a % expected).zero());
+    ASSERT_TRUE((b % expected).zero());
+
+    aint s, t;
+    ASSERT_EQ(xgcd(a, b, s, t), expected);
+    ASSERT_EQ(a * s - b * t, expected);
+    ASSERT_LE(s, b / expected);
+    ASSERT_LT(t, a / expected);
+    ASSERT_EQ(xgcd(b, a, s, t), expected);
+    ASSERT_EQ(b * s - a * t, expected);
+
+    aint m = b / expected, x = modinv(a / expected, m);
+    ASSERT_LT(x, m);
+    ASSERT_EQ(a / expected * x % m, one % m);
+  }
+
+  aint s, t;
+  ASSERT_EQ(xgcd(aint(7u), aint(), s, t), aint(7u));
+  ASSERT_EQ(s, one);
+  ASSERT_TRUE(t.zero());
+  ASSERT_EQ(xgcd(aint(5u), aint(15u), s, t), aint(5u));
+  ASSERT_EQ(aint(5u) * s - aint(15u) * t, aint(5u));
+  ASSERT_THROW(xgcd(aint(), aint(3u), s, t), std::invalid_argument);
+  ASSERT_EQ(modinv(aint(3u), aint(7u)), aint(5u));
+  ASSERT_TRUE(modinv(aint(3u), one).zero());
+  ASSERT_THROW(modinv(aint(6u), aint(9u)), std::invalid_argument);
+  ASSERT_THROW(modinv(aint(9u), aint(9u)), std::invalid_argument);
+  ASSERT_THROW(modinv(aint(2u), aint()), std::invalid_argument);
+}
+TEST(AInt, Roots) {
+  ASSERT_TRUE(isqrt(aint()).zero());
+  ASSERT_EQ(isqrt(aint(1u)), aint(1u));
+  ASSERT_EQ(isqrt(aint(15u)), aint(3u));
+  ASSERT_EQ(isqrt(aint(16u)), aint(4u));
+  ASSERT_EQ(iroot(aint(26u), 3), aint(2u));
+  ASSERT_EQ(iroot(aint(27u), 3), aint(3u));
+  ASSERT_EQ(iroot(aint(1000u), 1), aint(1000u));
+  ASSERT_EQ(iroot(aint(1000u), 40), aint(1u));
+  ASSERT_THROW(iroot(aint(8u), 0), std::invalid_argument);
+
+  for (size_t size : {1, 2, 3, 20, 300}) {
+    aint a = random_aint(size, static_cast<uint32_t>(size) + 30);
+    for (unsigned k : {2u, 3u, 5u, 17u}) {
+      aint root = iroot(a, k), one = 1u;
+      aint lower = one, upper = one;
+      for (unsigned i = 0; i < k; i++) {
+        lower *= root;
+        upper *= root + one;
+      }
+      ASSERT_LE(lower, a);
+      ASSERT_GT(upper, a);
+    }
+    aint r = isqrt(a);
+    ASSERT_TRUE(is_perfect_square(r * r));
+    ASSERT_EQ(isqrt(r * r), r);
+    ASSERT_EQ(isqrt(r * r - aint(1u)), r - aint(1u));
+    ASSERT_FALSE(is_perfect_square(r * r + aint(1u)));
+    ASSERT_FALSE(is_perfect_square(r * r + r + r));
+  }
+  ASSERT_TRUE(is_perfect_square(aint()));
+  ASSERT_FALSE(is_perfect_square(aint(2u)));
+}
+TEST(AInt, Operation_bitwise) {
+  aint a = aint::from_string("f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0ff", 16);
+  aint b = aint::from_string("ff00ff00ff00", 16);
+  ASSERT_EQ(a & b, aint::from_string("f000f000f000", 16));
+  ASSERT_EQ(b & a, a & b);
+  ASSERT_EQ(a | b, aint::from_string("f0f0f0f0f0f0f0f0f0f0f0fff0fff0ffff", 16));
+  ASSERT_EQ(b | a, a | b);
+  ASSERT_EQ(a ^ b, aint::from_string("f0f0f0f0f0f0f0f0f0f0f00ff00ff00fff", 16));
+  ASSERT_EQ(b ^ a, a ^ b);
+  ASSERT_TRUE((a ^ a).zero());
+  ASSERT_TRUE((a & aint()).zero());
+  ASSERT_EQ(a | aint(), a);
+  ASSERT_EQ(~a, aint::from_string("f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f00", 16));
+  ASSERT_TRUE((~aint()).zero());
+  ASSERT_TRUE((~aint(1u)).zero());
+
+  // Long enough for the vectorized loops, with scalar tails.
+  aint c = random_aint(103, 17), d = random_aint(77, 18);
+  ASSERT_EQ((c & d) + (c | d), c + d);
+  ASSERT_EQ((c ^ d) + ((c & d) << 1), c + d);
+  ASSERT_EQ(c + ~c, (aint(1u) << c.bit_length()) - aint(1u));
+
+  aint one = 1u;
+  ASSERT_EQ(aint().bit_length(), 0u);
+  ASSERT_EQ(one.bit_length(), 1u);
+  ASSERT_EQ((one << 1000).bit_length(), 1001u);
+  ASSERT_EQ(((one << 1000) - one).popcount(), 1000u);
+  ASSERT_EQ(aint().popcount(), 0u);
+  ASSERT_EQ((one << 1000).count_trailing_zeros(), 1000u);
+  ASSERT_EQ(aint(12u).count_trailing_zeros(), 2u);
+  ASSERT_EQ(aint().count_trailing_zeros(), 0u);
+  ASSERT_TRUE((one << 1000).test_bit(1000));
+  ASSERT_FALSE((one << 1000).test_bit(999));
+  ASSERT_FALSE((one << 1000).test_bit(5000));
+}
+TEST(AInt, View) {
+  aint a = random_aint(50, 19), b = random_aint(30, 20);
+  std::vector<block_t> blocks(a.get_blocks(), a.get_blocks() + a.size());
+  blocks.push_back(0);
+  aint_view v(blocks.data(), blocks.size());
+  ASSERT_EQ(v.size(), a.size());
+  ASSERT_EQ(v.data(), blocks.data());
+  ASSERT_TRUE(v == a);
+  ASSERT_TRUE(a == v);
+  ASSERT_TRUE(v > b);
+  ASSERT_TRUE(b < v);
+  ASSERT_EQ(v + b, a + b);
+  ASSERT_EQ(b + v, a + b);
+  ASSERT_EQ(v * b, a * b);
+  ASSERT_EQ(v - b, a - b);
+  ASSERT_EQ(v % b, a % b);
+  ASSERT_EQ(v >> 37, a >> 37);
+  ASSERT_EQ(gcd(v, b), gcd(a, b));
+  aint_view w = v;
+  ASSERT_EQ(w.data(), blocks.data());
+  aint c = w;
+  ASSERT_EQ(c, a);
+  c += v;
+  ASSERT_EQ(c, a + a);
+  ASSERT_TRUE(aint_view().value().zero());
+
+  std::stringstream stream;
+  serialize(a, stream);
+  serialize(aint(), stream);
+  ASSERT_EQ(deserialize(stream), a);
+  ASSERT_TRUE(deserialize(stream).zero());
+  ASSERT_THROW(deserialize(stream), std::invalid_argument);
+  aint large = (aint(1u) << (BLOCK_WIDTH * 200000)) - aint(1u);
+  std::stringstream large_stream;
+  serialize(large, large_stream);
+  ASSERT_EQ(deserialize(large_stream), large);
+  // Headers claiming more blocks than the stream holds.
+  for (uint64_t size : {(uint64_t(1) << 61) + 1, uint64_t(1) << 40}) {
+    uint64_t header[4] = {BLOCK_WIDTH, size, 1, 2};
+    std::stringstream truncated(
+        std::string(reinterpret_cast<const char *>(header), sizeof(header)));
+    ASSERT_THROW(deserialize(truncated), std::invalid_argument);
+  }
+
+  std::string bytes = stream.str();
+  std::vector<uint64_t> buffer(bytes.size() / sizeof(uint64_t) + 1);
+  std::memcpy(buffer.data(), bytes.data(), bytes.size());
+  aint_view d = deserialize_view(buffer.data(), bytes.size());
+  ASSERT_EQ(d, a);
+  ASSERT_EQ(static_cast<const void *>(d.data()),
+            static_cast<const void *>(buffer.data() + 2));
+  ASSERT_THROW(deserialize_view(buffer.data(),
+                                16 + a.size() * sizeof(block_t) - 1),
+               std::invalid_argument);
+
+#if AINT_HAVE_MAPPING
+  std::string path = testing::TempDir() + "aint_view";
+  {
+    std::ofstream file(path, std::ios::binary);
+    serialize(a, file);
+  }
+  {
+    aint_mapping mapping(path.c_str());
+    ASSERT_EQ(mapping.view() * b, a * b);
+  }
+  std::remove(path.c_str());
+#endif
+}
+TEST(AInt, Faint) {
+  typedef faint<256> f256;
+  constexpr faint<128> x = (faint<128>(1u) << 100) - faint<128>(1u);
+  static_assert(x.popcount() == 100, "constexpr shift and subtraction");
+  static_assert(x / faint<128>(3u) * faint<128>(3u) == x,
+                "constexpr short division");
+  static_assert(x % (faint<128>(1u) << 40) ==
+                    (faint<128>(1u) << 40) - faint<128>(1u),
+                "constexpr long division");
+  static_assert((~faint<128>()).bit_length() == 128, "constexpr complement");
+
+  aint modulus = aint(1u) << 256;
+  for (uint32_t seed = 0; seed < 20; seed++) {
+    aint a = random_aint(256 / BLOCK_WIDTH, seed) % modulus;
+    aint b = random_aint(seed % (256 / BLOCK_WIDTH) + 1, seed + 100);
+    f256 fa(a), fb(b);
+    ASSERT_EQ(aint(fa), a);
+    ASSERT_EQ(fa.view(), a);
+    ASSERT_EQ(aint(fa + fb), (a + b) % modulus);
+    ASSERT_EQ(aint(fb - fa), (b + modulus - a) % modulus);
+    ASSERT_EQ(aint(fa * fb), a * b % modulus);
+    ASSERT_EQ(aint(fa * fa), a * a % modulus);
+    ASSERT_EQ(aint(fa / fb), a / b);
+    ASSERT_EQ(aint(fa % fb), a % b);
+    ASSERT_EQ(aint(fa << 77), (a << 77) % modulus);
+    ASSERT_EQ(aint(fa >> 77), a >> 77);
+    ASSERT_EQ(aint(fa ^ fb), a ^ b);
+    ASSERT_EQ(fa < fb, a < b);
+    ASSERT_EQ(fa.bit_length(), a.bit_length());
+  }
+  ASSERT_THROW(f256(1u) / f256(), std::invalid_argument);
+  ASSERT_EQ(f256(aint(5u) + modulus), f256(5u));
+}
+TEST(AInt, Literal) {
+  using namespace aint_literals;
+  ASSERT_EQ(0x123456789abcdef0123456789ABCDEF_ai,
+            aint::from_string("123456789abcdef0123456789abcdef", 16));
+  ASSERT_EQ(123456789012345678901234567890123456789_ai,
+            aint::from_string("123456789012345678901234567890123456789", 10));
+  ASSERT_EQ(0b1011_ai, aint(11u));
+  ASSERT_EQ(0755_ai, aint(493u));
+  ASSERT_EQ(1'000'000_ai, aint(1000000u));
+  ASSERT_TRUE((0_ai).value().zero());
+  ASSERT_TRUE((0x0000_ai).value().zero());
+
+  // The blocks are shared by every evaluation of the same literal.
+  aint_view a = 0xffffffffffffffffffffffff_ai, b = 0xffffffffffffffffffffffff_ai;
+  ASSERT_EQ(a.data(), b.data());
+  aint c = a;
+  ASSERT_EQ(c + 1u, aint(1u) << 96);
+  ASSERT_EQ(c * 0x10_ai, c << 4);
+  ASSERT_EQ(0x10_ai * c, c << 4);
+}
+TEST(AInt, Batch) {
+  // Not a multiple of the vector width, to cover the scalar tail.
+  const size_t count = 37, blocks = 4;
+  aint modulus = aint(1u) << (blocks * BLOCK_WIDTH);
+  aint_batch a(count, blocks), b(count, blocks);
+  std::vector<aint> x, y;
+  for (uint32_t i = 0; i < count; i++) {
+    x.push_back(random_aint(i % blocks + 1, i) % modulus);
+    y.push_back(i % 3 == 0 ? x.back() : random_aint(blocks - i % 2, i + 50));
+    a.scatter(i, x.back());
+    b.scatter(i, y.back());
+  }
+  ASSERT_EQ(a.count(), count);
+  ASSERT_EQ(a.blocks(), blocks);
+  ASSERT_EQ(a.gather(5), x[5]);
+  ASSERT_THROW(a.scatter(0, modulus), std::invalid_argument);
+
+  std::vector<int> order(count);
+  a.compare(b, order.data());
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(order[i], x[i] < y[i] ? -1 : x[i] > y[i] ? 1 : 0);
+  }
+
+  bool overflowed = false;
+  for (size_t i = 0; i < count; i++) {
+    overflowed |= x[i] + y[i] >= modulus;
+  }
+  ASSERT_EQ(a.add(b), overflowed);
+  for (size_t i = 0; i < count; i++) {
+    ASSERT_EQ(a.gather(i), (x[i] + y[i]) % modulus);
+  }
+
+  block_t u = 0x9e3779b9u;
+  overflowed = false;
+  for (size_t i = 0; i < count; i++) {
+    overflowed |= b.gather(i) * u >= modulus;
+  }
+  aint expected = b.gather(7) * u % modulus;
+  ASSERT_EQ(b.mul_small(u), overflowed);
+  ASSERT_EQ(b.gather(7), expected);
+
+  aint_batch c(count, blocks + 1);
+  ASSERT_THROW(a.add(c), std::invalid_argument);
+  c.scatter(0, aint(1u));
+  ASSERT_FALSE(c.add(c));
+  ASSERT_EQ(c.gather(0), aint(2u));
+}
 TEST(AInt, Operation_left_bitshift) {
   aint a = const_cast<char*>("1110000000000000000000000000000011");
   aint b = a << 2;